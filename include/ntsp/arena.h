@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <cstdlib>
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+namespace ntsp {
+namespace detail {
+
+class arena final
+{
+public:
+    static arena * create( std::size_t slot_count, std::size_t slot_size )
+    {
+        if( slot_count > max_slot_count( slot_size ) )
+        {
+            throw std::bad_array_new_length();
+        }
+
+        const auto memory = static_cast< char * >( std::malloc( header_size + slot_count * slot_size ) );
+        if( ! memory )
+        {
+            throw std::bad_alloc();
+        }
+
+        return new( memory ) arena( slot_count, slot_size );
+    }
+
+    // Most slots of the given size one arena holds before its size overflows
+    [[ nodiscard ]] constexpr static std::size_t max_slot_count( std::size_t slot_size ) noexcept
+    {
+        return ( std::numeric_limits< std::size_t >::max() - header_size ) / ( slot_size ? slot_size : 1 );
+    }
+
+    arena( const arena & ) = delete;
+    arena & operator =( const arena & ) = delete;
+
+public:
+    [[ nodiscard ]] void * slot( std::size_t index ) noexcept
+    {
+        return reinterpret_cast< char * >( this ) + header_size + index * m_slot_size;
+    }
+
+    [[ nodiscard ]] std::size_t slot_count() const noexcept
+    {
+        return m_slot_count;
+    }
+
+    void acquire() noexcept
+    {
+        m_references.fetch_add( 1, std::memory_order_relaxed );
+    }
+
+    void release() noexcept
+    {
+        if( m_references.fetch_sub( 1, std::memory_order_acq_rel ) != 1 )
+        {
+            return;
+        }
+
+        this->~arena();
+        std::free( this );
+    }
+
+private:
+    constexpr static std::size_t header_size = ( sizeof( std::atomic_size_t ) + 2 * sizeof( std::size_t ) + alignof( std::max_align_t ) - 1 )
+                                               / alignof( std::max_align_t ) * alignof( std::max_align_t );
+
+    std::atomic_size_t m_references;
+    const std::size_t m_slot_count;
+    const std::size_t m_slot_size;
+
+private:
+    arena( std::size_t slot_count, std::size_t slot_size ) noexcept
+            : m_references( 1 )
+            , m_slot_count( slot_count )
+            , m_slot_size( slot_size )
+    {
+
+    }
+
+    ~arena() = default;
+};
+
+template< typename Counter, typename Value >
+struct arena_slot final
+{
+    arena * owner;
+    std::aligned_storage_t< sizeof( Counter ), alignof( Counter ) > counter;
+    std::aligned_storage_t< sizeof( Value ), alignof( Value ) > value;
+};
+
+}
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ntsp {
+namespace detail {
+
+class deferred_release_buffer final
+{
+public:
+    using release_function = void ( * )( void * counter, void * value, std::size_t count ) noexcept;
+
+    constexpr static std::size_t capacity = 128;
+    constexpr static std::size_t max_pending = capacity * 3 / 4;
+
+    inline static constinit thread_local deferred_release_buffer * current = nullptr;
+
+public:
+    deferred_release_buffer() noexcept = default;
+    deferred_release_buffer( const deferred_release_buffer & ) = delete;
+    deferred_release_buffer & operator =( const deferred_release_buffer & ) = delete;
+
+    ~deferred_release_buffer()
+    {
+        flush();
+    }
+
+public:
+    void defer( void * counter, void * value, release_function release ) noexcept
+    {
+        auto index = hash( counter );
+        while( m_entries[ index ].counter && m_entries[ index ].counter != counter )
+        {
+            index = ( index + 1 ) & ( capacity - 1 );
+        }
+
+        auto & entry = m_entries[ index ];
+        if( entry.counter )
+        {
+            ++entry.count;
+            return;
+        }
+
+        entry = { counter, value, release, 1 };
+        if( ++m_pending == max_pending )
+        {
+            flush();
+        }
+    }
+
+    void flush() noexcept
+    {
+        if( 0 == m_pending )
+        {
+            return;
+        }
+
+        entry entries[ capacity ];
+        for( std::size_t index = 0; index < capacity; ++index )
+        {
+            entries[ index ] = m_entries[ index ];
+            m_entries[ index ] = {};
+        }
+        m_pending = 0;
+
+        // Destructors run from here may release more pointers, those go straight to their counters
+        const auto previous = current;
+        current = nullptr;
+        for( const auto & entry : entries )
+        {
+            if( entry.counter )
+            {
+                entry.release( entry.counter, entry.value, entry.count );
+            }
+        }
+        current = previous;
+    }
+
+private:
+    struct entry
+    {
+        void * counter = nullptr;
+        void * value = nullptr;
+        release_function release = nullptr;
+        std::size_t count = 0;
+    };
+
+    entry m_entries[ capacity ];
+    std::size_t m_pending = 0;
+
+private:
+    static std::size_t hash( const void * counter ) noexcept
+    {
+        constexpr auto bits = 7;
+        static_assert( std::size_t( 1 ) << bits == capacity, "Capacity must match hash width" );
+
+        const auto key = static_cast< std::uint64_t >( reinterpret_cast< std::uintptr_t >( counter ) >> 4 );
+        return static_cast< std::size_t >( ( key * 0x9E3779B97F4A7C15ull ) >> ( 64 - bits ) );
+    }
+};
+
+}
+
+// While alive, strong releases of thread safe pointers on this thread are buffered and coalesced per counter,
+// instead of each one doing a synchronized decrement. Values die only when the buffer is flushed:
+// once it is full, on flush() at a quiescent point, or when the scope ends. Weak pointers may still lock
+// values with pending releases, since those are alive until the flush.
+class deferred_release_scope final
+{
+public:
+    deferred_release_scope() noexcept
+            : m_previous( detail::deferred_release_buffer::current )
+    {
+        detail::deferred_release_buffer::current = &m_buffer;
+    }
+
+    deferred_release_scope( const deferred_release_scope & ) = delete;
+    deferred_release_scope & operator =( const deferred_release_scope & ) = delete;
+
+    ~deferred_release_scope()
+    {
+        m_buffer.flush();
+        detail::deferred_release_buffer::current = m_previous;
+    }
+
+public:
+    void flush() noexcept
+    {
+        m_buffer.flush();
+    }
+
+private:
+    detail::deferred_release_buffer m_buffer;
+    detail::deferred_release_buffer * m_previous;
+};
+
+inline void flush_deferred_releases() noexcept
+{
+    if( const auto buffer = detail::deferred_release_buffer::current )
+    {
+        buffer->flush();
+    }
+}
+
+}
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
 #include <ntsp/shared_pointer.h>
 #include <ntsp/weak_pointer.h>
 
@@ -19,11 +23,15 @@ public:
     [[ nodiscard ]] shared_pointer< value_type, thread_policy > shared_from_this() noexcept
     {
         assert( m_reference_counter && "Was not shared" );
-        return shared_pointer< value_type, thread_policy >( m_reference_counter, reinterpret_cast< Value * >( this ) );
+        return shared_pointer< value_type, thread_policy >( m_reference_counter, static_cast< Value * >( this ) );
     }
 
     [[ nodiscard ]] weak_pointer< value_type, thread_policy > weak_from_this() noexcept
     {
+        if( ! m_reference_counter )
+        {
+            return weak_pointer< value_type, thread_policy >();
+        }
         return weak_pointer< value_type, thread_policy  >( shared_from_this() );
     }
 
@@ -38,4 +46,87 @@ private:
     reference_counter< thread_policy > * m_reference_counter = nullptr;
 };
 
-}
\ No newline at end of file
+// Zero size alternative without a vtable or a back pointer. Values made by make() sit right behind their
+// counter, so it is found from the value address. Values adopted from a raw pointer are registered by
+// address in a table per type, which is only searched while it is not empty.
+// Value must be the exact type the shared pointer holds and must be owned by one when this is called.
+template< typename Value, thread_policy_e Policy = thread_policy_e::safe >
+class compact_enable_shared_from_this
+{
+public:
+    using value_type = Value;
+    constexpr static auto thread_policy = Policy;
+
+public:
+    [[ nodiscard ]] shared_pointer< value_type, thread_policy > shared_from_this() noexcept
+    {
+        static_assert( alignof( value_type ) <= alignof( reference_counter_t ), "Over-aligned values are not placed right behind their counter" );
+
+        const auto value = static_cast< value_type * >( this );
+        return shared_pointer< value_type, thread_policy >( counter_of( value ), value );
+    }
+
+    [[ nodiscard ]] weak_pointer< value_type, thread_policy > weak_from_this() noexcept
+    {
+        return weak_pointer< value_type, thread_policy >( shared_from_this() );
+    }
+
+protected:
+    compact_enable_shared_from_this() noexcept = default;
+    compact_enable_shared_from_this( const compact_enable_shared_from_this & ) noexcept = default;
+    compact_enable_shared_from_this & operator =( const compact_enable_shared_from_this & ) noexcept = default;
+    ~compact_enable_shared_from_this() = default;
+
+private:
+    friend class shared_pointer< value_type, thread_policy >;
+
+    using reference_counter_t = reference_counter< thread_policy >;
+    using pointer_type = shared_pointer< value_type, thread_policy >;
+
+    struct adopted final
+    {
+        std::mutex mutex;
+        std::unordered_map< const void *, reference_counter_t * > counters;
+    };
+
+    inline static constinit std::atomic_size_t s_adopted_count{ 0 };
+
+private:
+    static adopted & adopted_values()
+    {
+        static adopted values;
+        return values;
+    }
+
+    static reference_counter_t * counter_of( value_type * value ) noexcept
+    {
+        if( s_adopted_count.load( std::memory_order_acquire ) )
+        {
+            auto & values = adopted_values();
+            std::lock_guard lock( values.mutex );
+            if( const auto found = values.counters.find( value ); found != values.counters.end() )
+            {
+                return found->second;
+            }
+        }
+        return reinterpret_cast< reference_counter_t * >( reinterpret_cast< char * >( value ) - pointer_type::reference_counter_size );
+    }
+
+    static void adopt( value_type * value, reference_counter_t * counter )
+    {
+        auto & values = adopted_values();
+        std::lock_guard lock( values.mutex );
+        values.counters.emplace( value, counter );
+        s_adopted_count.fetch_add( 1, std::memory_order_release );
+    }
+
+    static void forget( value_type * value ) noexcept
+    {
+        auto & values = adopted_values();
+        std::lock_guard lock( values.mutex );
+        values.counters.erase( value );
+        s_adopted_count.fetch_sub( 1, std::memory_order_relaxed );
+    }
+};
+
+}
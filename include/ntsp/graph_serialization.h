@@ -0,0 +1,620 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#if __has_include( <sys/mman.h> )
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define NTSP_HAS_MAPPED_GRAPH 1
+#endif
+
+#include <ntsp/arena.h>
+#include <ntsp/shared_pointer.h>
+
+namespace ntsp {
+
+// Specialize for every node type stored in a serialized graph:
+//     static void save( const Node & node, graph_output< Node, Policy > & output );
+//     static Node load( graph_input< Node, Policy > & input );
+// Payload is written with output.write(), outgoing links with output.write_edge(),
+// and read back in the same order.
+template< typename Node >
+struct graph_traits;
+
+template< typename Node, thread_policy_e Policy >
+class mapped_graph;
+
+namespace detail {
+
+constexpr char graph_magic[ 4 ] = { 'N', 'T', 'S', 'G' };
+constexpr std::uint32_t graph_version = 1;
+constexpr std::uint64_t graph_null_index = ~std::uint64_t( 0 );
+
+struct graph_header final
+{
+    char magic[ 4 ];
+    std::uint32_t version;
+    std::uint64_t node_count;
+    std::uint64_t root;
+    std::uint64_t index_offset;
+};
+
+struct graph_record final
+{
+    std::uint64_t payload_size;
+    std::uint64_t edge_count;
+};
+
+inline void validate_graph_header( const graph_header & header )
+{
+    if( std::memcmp( header.magic, graph_magic, sizeof( graph_magic ) ) != 0 || header.version != graph_version )
+    {
+        throw std::runtime_error( "ntsp: not a serialized graph" );
+    }
+
+    if( header.node_count != 0 && header.root >= header.node_count )
+    {
+        throw std::runtime_error( "ntsp: malformed graph root" );
+    }
+}
+
+}
+
+template< typename Node, thread_policy_e Policy = thread_policy_e::safe >
+class graph_output final
+{
+public:
+    using node_type = Node;
+    using pointer_type = shared_pointer< node_type, Policy >;
+
+public:
+    template< typename T >
+    void write( const T & value )
+    {
+        static_assert( std::is_trivially_copyable_v< T >, "Only trivially copyable values are written as is" );
+        write( &value, sizeof( T ) );
+    }
+
+    void write( const void * data, std::size_t size )
+    {
+        const auto bytes = static_cast< const char * >( data );
+        m_payload.insert( m_payload.end(), bytes, bytes + size );
+    }
+
+    void write_edge( const pointer_type & edge )
+    {
+        m_edges.push_back( &edge );
+    }
+
+private:
+    template< typename N, thread_policy_e P >
+    friend struct detail::graph_builder;
+
+private:
+    std::vector< char > m_payload;
+    std::vector< const pointer_type * > m_edges;
+
+private:
+    void clear() noexcept
+    {
+        m_payload.clear();
+        m_edges.clear();
+    }
+};
+
+template< typename Node, thread_policy_e Policy = thread_policy_e::safe >
+class graph_input final
+{
+public:
+    using node_type = Node;
+    using pointer_type = shared_pointer< node_type, Policy >;
+
+public:
+    template< typename T >
+    [[ nodiscard ]] T read()
+    {
+        static_assert( std::is_trivially_copyable_v< T >, "Only trivially copyable values are read as is" );
+        T value;
+        read( &value, sizeof( T ) );
+        return value;
+    }
+
+    void read( void * data, std::size_t size )
+    {
+        if( size > m_payload_size )
+        {
+            throw std::runtime_error( "ntsp: node payload exhausted" );
+        }
+
+        std::memcpy( data, m_payload, size );
+        m_payload += size;
+        m_payload_size -= size;
+    }
+
+    [[ nodiscard ]] pointer_type read_edge()
+    {
+        if( 0 == m_edge_count )
+        {
+            throw std::runtime_error( "ntsp: node edges exhausted" );
+        }
+
+        std::uint64_t index;
+        std::memcpy( &index, m_edges, sizeof( index ) );
+        m_edges += sizeof( index );
+        --m_edge_count;
+
+        return detail::graph_null_index == index ? pointer_type() : m_resolve( m_context, index );
+    }
+
+private:
+    template< typename N, thread_policy_e P >
+    friend struct detail::graph_builder;
+
+    template< typename N, thread_policy_e P >
+    friend class mapped_graph;
+
+    using resolver = pointer_type ( * )( void * context, std::uint64_t index );
+
+private:
+    const char * m_payload;
+    std::size_t m_payload_size;
+    const char * m_edges;
+    std::size_t m_edge_count;
+    resolver m_resolve;
+    void * m_context;
+
+private:
+    graph_input( const char * record, resolver resolve, void * context ) noexcept
+            : m_resolve( resolve )
+            , m_context( context )
+    {
+        detail::graph_record header;
+        std::memcpy( &header, record, sizeof( header ) );
+
+        m_payload = record + sizeof( header );
+        m_payload_size = header.payload_size;
+        m_edges = m_payload + m_payload_size;
+        m_edge_count = header.edge_count;
+    }
+};
+
+namespace detail {
+
+template< typename Node, thread_policy_e Policy >
+struct graph_builder final
+{
+    using pointer_type = shared_pointer< Node, Policy >;
+    using counter_type = reference_counter< Policy >;
+    using slot_type = arena_slot< counter_type, Node >;
+    using output_type = graph_output< Node, Policy >;
+    using input_type = graph_input< Node, Policy >;
+
+    constexpr static std::uint64_t in_progress = graph_null_index - 1;
+
+    static const void * identity( const pointer_type & pointer ) noexcept
+    {
+        return pointer.m_reference_counter;
+    }
+
+    static void save( std::ostream & stream, const pointer_type & root )
+    {
+        const auto header_position = stream.tellp();
+
+        graph_header header{};
+        std::memcpy( header.magic, graph_magic, sizeof( graph_magic ) );
+        header.version = graph_version;
+        header.root = graph_null_index;
+        stream.write( reinterpret_cast< const char * >( &header ), sizeof( header ) );
+
+        std::uint64_t position = sizeof( header );
+        std::vector< std::uint64_t > offsets;
+        std::unordered_map< const void *, std::uint64_t > indices;
+
+        struct frame
+        {
+            const pointer_type * node;
+            std::size_t next_edge;
+            output_type output;
+        };
+        std::vector< frame > frames;
+        std::size_t depth = 0;
+
+        const auto push = [ & ]( const pointer_type * node )
+        {
+            if( frames.size() == depth )
+            {
+                frames.emplace_back();
+            }
+
+            auto & top = frames[ depth++ ];
+            top.node = node;
+            top.next_edge = 0;
+            top.output.clear();
+
+            indices.emplace( identity( *node ), in_progress );
+            graph_traits< Node >::save( *node->get(), top.output );
+        };
+
+        if( ! root.empty() )
+        {
+            push( &root );
+        }
+
+        while( depth != 0 )
+        {
+            auto & top = frames[ depth - 1 ];
+            auto & edges = top.output.m_edges;
+
+            while( top.next_edge < edges.size() )
+            {
+                const auto edge = edges[ top.next_edge ];
+                if( edge->empty() )
+                {
+                    ++top.next_edge;
+                    continue;
+                }
+
+                const auto found = indices.find( identity( *edge ) );
+                if( found == indices.end() )
+                {
+                    break;
+                }
+                if( found->second == in_progress )
+                {
+                    throw std::invalid_argument( "ntsp: cyclic graphs can not be serialized" );
+                }
+                ++top.next_edge;
+            }
+
+            if( top.next_edge < edges.size() )
+            {
+                push( edges[ top.next_edge ] );
+                continue;
+            }
+
+            const graph_record record{ static_cast< std::uint64_t >( top.output.m_payload.size() ), static_cast< std::uint64_t >( edges.size() ) };
+            stream.write( reinterpret_cast< const char * >( &record ), sizeof( record ) );
+            stream.write( top.output.m_payload.data(), static_cast< std::streamsize >( top.output.m_payload.size() ) );
+            for( const auto edge : edges )
+            {
+                const auto index = edge->empty() ? graph_null_index : indices[ identity( *edge ) ];
+                stream.write( reinterpret_cast< const char * >( &index ), sizeof( index ) );
+            }
+
+            offsets.push_back( position );
+            position += sizeof( record ) + top.output.m_payload.size() + edges.size() * sizeof( std::uint64_t );
+            indices[ identity( *top.node ) ] = offsets.size() - 1;
+            --depth;
+        }
+
+        header.node_count = offsets.size();
+        header.root = offsets.empty() ? graph_null_index : offsets.size() - 1;
+        header.index_offset = position;
+        stream.write( reinterpret_cast< const char * >( offsets.data() ), static_cast< std::streamsize >( offsets.size() * sizeof( std::uint64_t ) ) );
+
+        const auto end_position = stream.tellp();
+        stream.seekp( header_position );
+        stream.write( reinterpret_cast< const char * >( &header ), sizeof( header ) );
+        stream.seekp( end_position );
+
+        if( ! stream )
+        {
+            throw std::ios_base::failure( "ntsp: failed to write graph" );
+        }
+    }
+
+    static pointer_type resolve_loaded( void * context, std::uint64_t index )
+    {
+        const auto & nodes = *static_cast< std::vector< pointer_type > * >( context );
+        if( index >= nodes.size() )
+        {
+            throw std::runtime_error( "ntsp: edge refers to a node not loaded yet" );
+        }
+        return nodes[ index ];
+    }
+
+    // Bytes left after the current position, unbounded for streams that can not seek
+    static std::uint64_t remaining_size( std::istream & stream )
+    {
+        const auto current = stream.tellg();
+        if( current == std::istream::pos_type( -1 ) || ! stream.seekg( 0, std::ios::end ) )
+        {
+            stream.clear();
+            return ~std::uint64_t( 0 );
+        }
+
+        const auto end = stream.tellg();
+        stream.seekg( current );
+        return static_cast< std::uint64_t >( end - current );
+    }
+
+    static pointer_type load( std::istream & stream )
+    {
+        graph_header header{};
+        if( ! stream.read( reinterpret_cast< char * >( &header ), sizeof( header ) ) )
+        {
+            throw std::runtime_error( "ntsp: truncated graph header" );
+        }
+        validate_graph_header( header );
+
+        if( 0 == header.node_count )
+        {
+            return pointer_type();
+        }
+
+        // Records lie between the header and the index, which must fit in what the stream still holds
+        std::uint64_t position = sizeof( header );
+        if( header.index_offset < position
+            || ( header.index_offset - position ) / sizeof( graph_record ) < header.node_count
+            || header.index_offset - position > remaining_size( stream )
+            || header.node_count > arena::max_slot_count( sizeof( slot_type ) ) )
+        {
+            throw std::runtime_error( "ntsp: malformed graph header" );
+        }
+
+        struct arena_hold
+        {
+            arena * owner;
+            ~arena_hold()
+            {
+                owner->release();
+            }
+        } hold{ arena::create( header.node_count, sizeof( slot_type ) ) };
+
+        std::vector< pointer_type > nodes;
+        nodes.reserve( header.node_count );
+        std::vector< char > record;
+
+        for( std::uint64_t index = 0; index < header.node_count; ++index )
+        {
+            graph_record record_header{};
+            if( ! stream.read( reinterpret_cast< char * >( &record_header ), sizeof( record_header ) ) )
+            {
+                throw std::runtime_error( "ntsp: truncated graph record" );
+            }
+
+            const auto available = header.index_offset - position - sizeof( record_header );
+            if( header.index_offset - position < sizeof( record_header )
+                || record_header.payload_size > available
+                || ( available - record_header.payload_size ) / sizeof( std::uint64_t ) < record_header.edge_count )
+            {
+                throw std::runtime_error( "ntsp: malformed graph record" );
+            }
+
+            const auto size = sizeof( record_header ) + record_header.payload_size + record_header.edge_count * sizeof( std::uint64_t );
+            position += size;
+            record.resize( size );
+            std::memcpy( record.data(), &record_header, sizeof( record_header ) );
+            if( ! stream.read( record.data() + sizeof( record_header ), static_cast< std::streamsize >( size - sizeof( record_header ) ) ) )
+            {
+                throw std::runtime_error( "ntsp: truncated graph record" );
+            }
+
+            input_type input( record.data(), &resolve_loaded, &nodes );
+            nodes.push_back( construct_in( *hold.owner, index, input ) );
+        }
+
+        return nodes[ header.root ];
+    }
+
+    static pointer_type construct_in( arena & owner, std::size_t index, input_type & input )
+    {
+        static_assert( offsetof( slot_type, counter ) == sizeof( arena * ), "Counter must follow its arena pointer" );
+        static_assert( alignof( slot_type ) <= alignof( std::max_align_t ), "Over-aligned nodes are not supported" );
+        static_assert( ! is_compact_enable_shared_from_this_v< Node, Policy >
+                       || offsetof( slot_type, value ) - offsetof( slot_type, counter ) == sizeof( slot_type::counter ), "Node must follow its counter" );
+
+        const auto slot = static_cast< slot_type * >( owner.slot( index ) );
+        slot->owner = &owner;
+
+        const auto counter = new( &slot->counter ) counter_type( counter_type::allocation_e::arena );
+        owner.acquire();
+
+        try
+        {
+            const auto value = ::new( &slot->value ) Node( graph_traits< Node >::load( input ) );
+            return pointer_type::from_created( counter, value );
+        }
+        catch( ... )
+        {
+            counter_type::deallocate( counter );
+            throw;
+        }
+    }
+
+    static pointer_type construct_shared( input_type & input )
+    {
+        return pointer_type::make( graph_traits< Node >::load( input ) );
+    }
+};
+
+}
+
+// Writes every node reachable from root exactly once, sharing is detected by reference counter identity.
+// Nodes are stored children first, edges are stored as node indices. The stream must be seekable.
+template< typename Node, thread_policy_e Policy >
+void save_graph( std::ostream & stream, const shared_pointer< Node, Policy > & root )
+{
+    detail::graph_builder< Node, Policy >::save( stream, root );
+}
+
+// Rebuilds the whole graph inside a single allocation, released once the last node is gone
+template< typename Node, thread_policy_e Policy = thread_policy_e::safe >
+shared_pointer< Node, Policy > load_graph( std::istream & stream )
+{
+    return detail::graph_builder< Node, Policy >::load( stream );
+}
+
+#ifdef NTSP_HAS_MAPPED_GRAPH
+
+// Maps a serialized graph and materializes nodes on demand, together with the nodes they refer to
+template< typename Node, thread_policy_e Policy = thread_policy_e::safe >
+class mapped_graph final
+{
+public:
+    using node_type = Node;
+    using pointer_type = shared_pointer< node_type, Policy >;
+
+public:
+    explicit mapped_graph( const std::string & path )
+    {
+        const auto descriptor = ::open( path.c_str(), O_RDONLY );
+        if( descriptor < 0 )
+        {
+            throw std::runtime_error( "ntsp: can not open " + path );
+        }
+
+        struct stat status{};
+        if( ::fstat( descriptor, &status ) != 0 || status.st_size < static_cast< off_t >( sizeof( detail::graph_header ) ) )
+        {
+            ::close( descriptor );
+            throw std::runtime_error( "ntsp: can not map " + path );
+        }
+
+        m_size = static_cast< std::size_t >( status.st_size );
+        const auto memory = ::mmap( nullptr, m_size, PROT_READ, MAP_PRIVATE, descriptor, 0 );
+        ::close( descriptor );
+        if( MAP_FAILED == memory )
+        {
+            throw std::runtime_error( "ntsp: can not map " + path );
+        }
+        m_memory = static_cast< const char * >( memory );
+
+        try
+        {
+            std::memcpy( &m_header, m_memory, sizeof( m_header ) );
+            detail::validate_graph_header( m_header );
+            if( m_header.index_offset > m_size || ( m_size - m_header.index_offset ) / sizeof( std::uint64_t ) < m_header.node_count )
+            {
+                throw std::runtime_error( "ntsp: malformed graph index" );
+            }
+        }
+        catch( ... )
+        {
+            ::munmap( const_cast< char * >( m_memory ), m_size );
+            throw;
+        }
+    }
+
+    mapped_graph( const mapped_graph & ) = delete;
+    mapped_graph & operator =( const mapped_graph & ) = delete;
+
+    ~mapped_graph()
+    {
+        m_nodes.clear();
+        ::munmap( const_cast< char * >( m_memory ), m_size );
+    }
+
+public:
+    [[ nodiscard ]] std::uint64_t size() const noexcept
+    {
+        return m_header.node_count;
+    }
+
+    [[ nodiscard ]] pointer_type root()
+    {
+        return 0 == m_header.node_count ? pointer_type() : load( m_header.root );
+    }
+
+    [[ nodiscard ]] pointer_type load( std::uint64_t index )
+    {
+        if( index >= m_header.node_count )
+        {
+            throw std::out_of_range( "ntsp: no such node" );
+        }
+
+        std::vector< std::uint64_t > pending{ index };
+        while( ! pending.empty() )
+        {
+            const auto current = pending.back();
+            if( m_nodes.count( current ) )
+            {
+                pending.pop_back();
+                continue;
+            }
+
+            const auto record = record_at( current );
+            const auto missing = find_missing_edge( record, current );
+            if( missing != detail::graph_null_index )
+            {
+                pending.push_back( missing );
+                continue;
+            }
+
+            graph_input< node_type, Policy > input( record, &resolve, this );
+            m_nodes.emplace( current, detail::graph_builder< node_type, Policy >::construct_shared( input ) );
+            pending.pop_back();
+        }
+
+        return m_nodes.at( index );
+    }
+
+private:
+    const char * m_memory = nullptr;
+    std::size_t m_size = 0;
+    detail::graph_header m_header{};
+    std::unordered_map< std::uint64_t, pointer_type > m_nodes;
+
+private:
+    const char * record_at( std::uint64_t index ) const
+    {
+        std::uint64_t offset;
+        std::memcpy( &offset, m_memory + m_header.index_offset + index * sizeof( offset ), sizeof( offset ) );
+
+        detail::graph_record record{};
+        if( offset > m_header.index_offset || m_header.index_offset - offset < sizeof( record ) )
+        {
+            throw std::runtime_error( "ntsp: malformed graph record" );
+        }
+        std::memcpy( &record, m_memory + offset, sizeof( record ) );
+
+        const auto available = m_header.index_offset - offset - sizeof( record );
+        if( record.payload_size > available || ( available - record.payload_size ) / sizeof( std::uint64_t ) < record.edge_count )
+        {
+            throw std::runtime_error( "ntsp: malformed graph record" );
+        }
+        return m_memory + offset;
+    }
+
+    std::uint64_t find_missing_edge( const char * record, std::uint64_t current ) const
+    {
+        detail::graph_record header;
+        std::memcpy( &header, record, sizeof( header ) );
+
+        const auto edges = record + sizeof( header ) + header.payload_size;
+        for( std::uint64_t edge = 0; edge < header.edge_count; ++edge )
+        {
+            std::uint64_t index;
+            std::memcpy( &index, edges + edge * sizeof( index ), sizeof( index ) );
+            if( index == detail::graph_null_index || m_nodes.count( index ) )
+            {
+                continue;
+            }
+            if( index >= current )
+            {
+                throw std::runtime_error( "ntsp: edge refers to a node not loaded yet" );
+            }
+            return index;
+        }
+        return detail::graph_null_index;
+    }
+
+    static pointer_type resolve( void * context, std::uint64_t index )
+    {
+        return static_cast< mapped_graph * >( context )->m_nodes.at( index );
+    }
+};
+
+#endif
+
+}
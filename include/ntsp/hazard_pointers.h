@@ -0,0 +1,158 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace ntsp {
+namespace detail {
+
+// Safe memory reclamation for lock-free containers. Before dereferencing a shared node a thread publishes
+// it in one of its hazard slots, retired nodes are deleted only once no slot of any thread holds them.
+// Records are never freed, a thread leaving returns its record for reuse together with whatever it
+// could not delete yet.
+class hazard_pointers final
+{
+public:
+    constexpr static std::size_t slots = 2;
+    constexpr static std::size_t min_retired = 64;
+
+    using deleter = void ( * )( void * ) noexcept;
+
+public:
+    class record final
+    {
+    public:
+        template< typename Node >
+        Node * protect( std::size_t slot, const std::atomic< Node * > & source ) noexcept
+        {
+            auto pointer = source.load( std::memory_order_relaxed );
+            for( ;; )
+            {
+                m_hazards[ slot ].store( pointer, std::memory_order_seq_cst );
+                const auto confirmed = source.load( std::memory_order_seq_cst );
+                if( confirmed == pointer )
+                {
+                    return pointer;
+                }
+                pointer = confirmed;
+            }
+        }
+
+        void clear( std::size_t slot ) noexcept
+        {
+            m_hazards[ slot ].store( nullptr, std::memory_order_release );
+        }
+
+        template< typename Node >
+        void retire( Node * node )
+        {
+            m_retired.push_back( { node, []( void * retired ) noexcept
+            {
+                delete static_cast< Node * >( retired );
+            } } );
+
+            if( m_retired.size() >= std::max( min_retired, 2 * slots * s_record_count.load( std::memory_order_relaxed ) ) )
+            {
+                scan();
+            }
+        }
+
+        void scan()
+        {
+            std::vector< const void * > hazards;
+            for( auto current = s_records.load( std::memory_order_acquire ); current; current = current->m_next )
+            {
+                for( const auto & hazard : current->m_hazards )
+                {
+                    if( const auto pointer = hazard.load( std::memory_order_seq_cst ) )
+                    {
+                        hazards.push_back( pointer );
+                    }
+                }
+            }
+            std::sort( hazards.begin(), hazards.end() );
+
+            const auto kept = std::partition( m_retired.begin(), m_retired.end(), [ &hazards ]( const retired & node )
+            {
+                return std::binary_search( hazards.begin(), hazards.end(), node.pointer );
+            } );
+
+            // Deleters may retire further nodes, so the list is settled before any of them runs
+            std::vector< retired > deleted( kept, m_retired.end() );
+            m_retired.erase( kept, m_retired.end() );
+            for( const auto & node : deleted )
+            {
+                node.destroy( node.pointer );
+            }
+        }
+
+    private:
+        friend class hazard_pointers;
+
+        struct retired final
+        {
+            void * pointer;
+            deleter destroy;
+        };
+
+        std::atomic< const void * > m_hazards[ slots ] = {};
+        std::atomic_bool m_active{ true };
+        record * m_next = nullptr;
+        std::vector< retired > m_retired;
+    };
+
+public:
+    [[ nodiscard ]] static record & local()
+    {
+        if( ! s_local )
+        {
+            s_local = acquire();
+            thread_local exit_guard guard;
+        }
+        return *s_local;
+    }
+
+private:
+    struct exit_guard final
+    {
+        ~exit_guard()
+        {
+            s_local->scan();
+            s_local->m_active.store( false, std::memory_order_release );
+            s_local = nullptr;
+        }
+    };
+
+    inline static constinit std::atomic< record * > s_records{ nullptr };
+    inline static constinit std::atomic_size_t s_record_count{ 0 };
+    inline static constinit thread_local record * s_local = nullptr;
+
+private:
+    static record * acquire()
+    {
+        for( auto current = s_records.load( std::memory_order_acquire ); current; current = current->m_next )
+        {
+            auto active = false;
+            if( ! current->m_active.load( std::memory_order_relaxed )
+                && current->m_active.compare_exchange_strong( active, true, std::memory_order_acquire, std::memory_order_relaxed ) )
+            {
+                return current;
+            }
+        }
+
+        const auto created = new record();
+        auto head = s_records.load( std::memory_order_relaxed );
+        do
+        {
+            created->m_next = head;
+        }
+        while( ! s_records.compare_exchange_weak( head, created, std::memory_order_release, std::memory_order_relaxed ) );
+        s_record_count.fetch_add( 1, std::memory_order_relaxed );
+        return created;
+    }
+};
+
+}
+}
@@ -0,0 +1,400 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <ntsp/shared_pointer.h>
+
+namespace ntsp {
+
+template< typename Key, typename Value, typename Hash, thread_policy_e Policy >
+class transient_map;
+
+namespace detail {
+
+// Hash array mapped trie, inline entries and child nodes are kept apart as in CHAMP.
+// Once hash bits run out, a node degrades to a plain list of colliding entries.
+template< typename Key, typename Value, typename Hash, thread_policy_e Policy >
+struct persistent_map_trie final
+{
+    constexpr static std::size_t bits = 5;
+    constexpr static std::size_t mask = ( std::size_t( 1 ) << bits ) - 1;
+    constexpr static std::size_t hash_bits = sizeof( std::size_t ) * 8;
+
+    using entry = std::pair< Key, Value >;
+
+    struct node;
+    using pointer = shared_pointer< node, Policy >;
+
+    struct node
+    {
+        std::uint32_t entry_map = 0;
+        std::uint32_t node_map = 0;
+        std::vector< entry > entries;
+        std::vector< pointer > children;
+    };
+
+    pointer root;
+    std::size_t size = 0;
+
+    static std::size_t hash( const Key & key )
+    {
+        return static_cast< std::size_t >( Hash{}( key ) );
+    }
+
+    static std::uint32_t bit( std::size_t hash, std::size_t shift ) noexcept
+    {
+        return std::uint32_t( 1 ) << ( ( hash >> shift ) & mask );
+    }
+
+    static std::size_t index( std::uint32_t map, std::uint32_t bit ) noexcept
+    {
+        return static_cast< std::size_t >( std::popcount( map & ( bit - 1 ) ) );
+    }
+
+    static node & edit( pointer & slot, bool transient )
+    {
+        if( ! transient || slot.use_count() != 1 )
+        {
+            slot = pointer::make( *slot );
+        }
+        return *slot;
+    }
+
+    [[ nodiscard ]] const Value * find( const Key & key ) const
+    {
+        if( 0 == size )
+        {
+            return nullptr;
+        }
+
+        const auto key_hash = hash( key );
+        auto current = root.get();
+        for( std::size_t shift = 0; shift < hash_bits; shift += bits )
+        {
+            const auto key_bit = bit( key_hash, shift );
+            if( current->entry_map & key_bit )
+            {
+                const auto & found = current->entries[ index( current->entry_map, key_bit ) ];
+                return found.first == key ? &found.second : nullptr;
+            }
+            if( ! ( current->node_map & key_bit ) )
+            {
+                return nullptr;
+            }
+            current = current->children[ index( current->node_map, key_bit ) ].get();
+        }
+
+        for( const auto & found : current->entries )
+        {
+            if( found.first == key )
+            {
+                return &found.second;
+            }
+        }
+        return nullptr;
+    }
+
+    static pointer merge( entry first, std::size_t first_hash, entry second, std::size_t second_hash, std::size_t shift )
+    {
+        auto merged = pointer::make();
+        if( shift >= hash_bits )
+        {
+            merged->entries.push_back( std::move( first ) );
+            merged->entries.push_back( std::move( second ) );
+            return merged;
+        }
+
+        const auto first_bit = bit( first_hash, shift );
+        const auto second_bit = bit( second_hash, shift );
+        if( first_bit == second_bit )
+        {
+            merged->node_map = first_bit;
+            merged->children.push_back( merge( std::move( first ), first_hash, std::move( second ), second_hash, shift + bits ) );
+            return merged;
+        }
+
+        merged->entry_map = first_bit | second_bit;
+        if( first_bit < second_bit )
+        {
+            merged->entries.push_back( std::move( first ) );
+            merged->entries.push_back( std::move( second ) );
+        }
+        else
+        {
+            merged->entries.push_back( std::move( second ) );
+            merged->entries.push_back( std::move( first ) );
+        }
+        return merged;
+    }
+
+    void set( Key key, Value value, bool transient )
+    {
+        if( 0 == size )
+        {
+            root = pointer::make();
+        }
+
+        if( set( root, entry( std::move( key ), std::move( value ) ), 0, transient ) )
+        {
+            ++size;
+        }
+    }
+
+    static bool set( pointer & slot, entry inserted, std::size_t shift, bool transient )
+    {
+        const auto key_hash = hash( inserted.first );
+        auto current = &edit( slot, transient );
+        for( ; shift < hash_bits; shift += bits )
+        {
+            const auto key_bit = bit( key_hash, shift );
+            if( current->entry_map & key_bit )
+            {
+                const auto position = index( current->entry_map, key_bit );
+                auto & existing = current->entries[ position ];
+                if( existing.first == inserted.first )
+                {
+                    existing.second = std::move( inserted.second );
+                    return false;
+                }
+
+                const auto existing_hash = hash( existing.first );
+                auto child = merge( std::move( existing ), existing_hash, std::move( inserted ), key_hash, shift + bits );
+                current->entries.erase( current->entries.begin() + static_cast< std::ptrdiff_t >( position ) );
+                current->entry_map ^= key_bit;
+                current->node_map |= key_bit;
+                current->children.insert( current->children.begin() + static_cast< std::ptrdiff_t >( index( current->node_map, key_bit ) ), std::move( child ) );
+                return true;
+            }
+
+            if( current->node_map & key_bit )
+            {
+                current = &edit( current->children[ index( current->node_map, key_bit ) ], transient );
+                continue;
+            }
+
+            current->entry_map |= key_bit;
+            current->entries.insert( current->entries.begin() + static_cast< std::ptrdiff_t >( index( current->entry_map, key_bit ) ), std::move( inserted ) );
+            return true;
+        }
+
+        for( auto & existing : current->entries )
+        {
+            if( existing.first == inserted.first )
+            {
+                existing.second = std::move( inserted.second );
+                return false;
+            }
+        }
+        current->entries.push_back( std::move( inserted ) );
+        return true;
+    }
+
+    void erase( const Key & key, bool transient )
+    {
+        if( ! find( key ) )
+        {
+            return;
+        }
+
+        if( 1 == size )
+        {
+            *this = {};
+            return;
+        }
+
+        erase( root, key, hash( key ), 0, transient );
+        --size;
+    }
+
+    static void erase( pointer & slot, const Key & key, std::size_t key_hash, std::size_t shift, bool transient )
+    {
+        auto & current = edit( slot, transient );
+        if( shift >= hash_bits )
+        {
+            for( auto found = current.entries.begin(); found != current.entries.end(); ++found )
+            {
+                if( found->first == key )
+                {
+                    current.entries.erase( found );
+                    return;
+                }
+            }
+            return;
+        }
+
+        const auto key_bit = bit( key_hash, shift );
+        if( current.entry_map & key_bit )
+        {
+            current.entries.erase( current.entries.begin() + static_cast< std::ptrdiff_t >( index( current.entry_map, key_bit ) ) );
+            current.entry_map ^= key_bit;
+            return;
+        }
+
+        const auto position = index( current.node_map, key_bit );
+        erase( current.children[ position ], key, key_hash, shift + bits, transient );
+
+        // A child left with a single entry is pulled back into this node
+        const auto & child = *current.children[ position ];
+        if( child.children.empty() && 1 == child.entries.size() )
+        {
+            auto pulled = child.entries.front();
+            current.children.erase( current.children.begin() + static_cast< std::ptrdiff_t >( position ) );
+            current.node_map ^= key_bit;
+            current.entry_map |= key_bit;
+            current.entries.insert( current.entries.begin() + static_cast< std::ptrdiff_t >( index( current.entry_map, key_bit ) ), std::move( pulled ) );
+        }
+    }
+
+    template< typename Function >
+    static void for_each( const node & current, Function & function )
+    {
+        for( const auto & found : current.entries )
+        {
+            function( found.first, found.second );
+        }
+        for( const auto & child : current.children )
+        {
+            for_each( *child, function );
+        }
+    }
+};
+
+}
+
+// Immutable hash map, every update returns a new version sharing all untouched nodes with this one
+template< typename Key, typename Value, typename Hash = std::hash< Key >, thread_policy_e Policy = thread_policy_e::safe >
+class persistent_map final
+{
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using size_type = std::size_t;
+    constexpr static thread_policy_e thread_policy = Policy;
+
+public:
+    persistent_map() = default;
+
+public:
+    [[ nodiscard ]] size_type size() const noexcept
+    {
+        return m_trie.size;
+    }
+
+    [[ nodiscard ]] bool empty() const noexcept
+    {
+        return 0 == m_trie.size;
+    }
+
+    [[ nodiscard ]] const mapped_type * find( const key_type & key ) const
+    {
+        return m_trie.find( key );
+    }
+
+    [[ nodiscard ]] bool contains( const key_type & key ) const
+    {
+        return m_trie.find( key ) != nullptr;
+    }
+
+    template< typename Function >
+    void for_each( Function function ) const
+    {
+        if( m_trie.size )
+        {
+            trie::for_each( *m_trie.root, function );
+        }
+    }
+
+public:
+    [[ nodiscard ]] persistent_map set( key_type key, mapped_type value ) const
+    {
+        auto result = *this;
+        result.m_trie.set( std::move( key ), std::move( value ), false );
+        return result;
+    }
+
+    [[ nodiscard ]] persistent_map erase( const key_type & key ) const
+    {
+        auto result = *this;
+        result.m_trie.erase( key, false );
+        return result;
+    }
+
+    [[ nodiscard ]] transient_map< key_type, mapped_type, Hash, thread_policy > transient() const
+    {
+        return transient_map< key_type, mapped_type, Hash, thread_policy >( m_trie );
+    }
+
+private:
+    friend class transient_map< key_type, mapped_type, Hash, thread_policy >;
+
+    using trie = detail::persistent_map_trie< key_type, mapped_type, Hash, thread_policy >;
+    trie m_trie;
+
+private:
+    explicit persistent_map( trie trie ) noexcept
+            : m_trie( std::move( trie ) )
+    {
+
+    }
+};
+
+// Batch editing mode, mutates in place every node it owns exclusively
+template< typename Key, typename Value, typename Hash = std::hash< Key >, thread_policy_e Policy = thread_policy_e::safe >
+class transient_map final
+{
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using size_type = std::size_t;
+    constexpr static thread_policy_e thread_policy = Policy;
+
+public:
+    transient_map() = default;
+
+public:
+    [[ nodiscard ]] size_type size() const noexcept
+    {
+        return m_trie.size;
+    }
+
+    [[ nodiscard ]] const mapped_type * find( const key_type & key ) const
+    {
+        return m_trie.find( key );
+    }
+
+    void set( key_type key, mapped_type value )
+    {
+        m_trie.set( std::move( key ), std::move( value ), true );
+    }
+
+    void erase( const key_type & key )
+    {
+        m_trie.erase( key, true );
+    }
+
+    // Snapshot, further edits of this transient copy the nodes shared with it
+    [[ nodiscard ]] persistent_map< key_type, mapped_type, Hash, thread_policy > persistent() const
+    {
+        return persistent_map< key_type, mapped_type, Hash, thread_policy >( m_trie );
+    }
+
+private:
+    friend class persistent_map< key_type, mapped_type, Hash, thread_policy >;
+
+    using trie = detail::persistent_map_trie< key_type, mapped_type, Hash, thread_policy >;
+    trie m_trie;
+
+private:
+    explicit transient_map( trie trie ) noexcept
+            : m_trie( std::move( trie ) )
+    {
+
+    }
+};
+
+}
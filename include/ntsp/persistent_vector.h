@@ -0,0 +1,304 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include <ntsp/shared_pointer.h>
+
+namespace ntsp {
+
+template< typename Value, thread_policy_e Policy >
+class transient_vector;
+
+namespace detail {
+
+// Bit-partitioned trie with 32-way branching, values live in leaves only
+template< typename Value, thread_policy_e Policy >
+struct persistent_vector_trie final
+{
+    constexpr static std::size_t bits = 5;
+    constexpr static std::size_t branching = std::size_t( 1 ) << bits;
+    constexpr static std::size_t mask = branching - 1;
+
+    struct node;
+    using pointer = shared_pointer< node, Policy >;
+
+    struct node
+    {
+        std::vector< pointer > children;
+        std::vector< Value > values;
+    };
+
+    pointer root;
+    std::size_t size = 0;
+    std::size_t shift = 0;
+
+    [[ nodiscard ]] const Value & get( std::size_t index ) const noexcept
+    {
+        auto current = root.get();
+        for( auto level = shift; level > 0; level -= bits )
+        {
+            current = current->children[ ( index >> level ) & mask ].get();
+        }
+        return current->values[ index & mask ];
+    }
+
+    // Transient edits reuse nodes nobody else refers to, everything else is path copied
+    static node & edit( pointer & slot, bool transient )
+    {
+        if( ! transient || slot.use_count() != 1 )
+        {
+            slot = pointer::make( *slot );
+        }
+        return *slot;
+    }
+
+    static pointer make_path( std::size_t level, Value value )
+    {
+        auto leaf = pointer::make();
+        leaf->values.push_back( std::move( value ) );
+        for( ; level > 0; level -= bits )
+        {
+            auto parent = pointer::make();
+            parent->children.push_back( std::move( leaf ) );
+            leaf = std::move( parent );
+        }
+        return leaf;
+    }
+
+    void push_back( Value value, bool transient )
+    {
+        if( 0 == size )
+        {
+            root = make_path( 0, std::move( value ) );
+            shift = 0;
+        }
+        else if( size == std::size_t( 1 ) << ( shift + bits ) )
+        {
+            auto grown = pointer::make();
+            grown->children.push_back( std::move( root ) );
+            grown->children.push_back( make_path( shift, std::move( value ) ) );
+            root = std::move( grown );
+            shift += bits;
+        }
+        else
+        {
+            auto current = &edit( root, transient );
+            for( auto level = shift; level > 0; level -= bits )
+            {
+                const auto child = ( size >> level ) & mask;
+                if( child == current->children.size() )
+                {
+                    current->children.push_back( make_path( level - bits, std::move( value ) ) );
+                    ++size;
+                    return;
+                }
+                current = &edit( current->children[ child ], transient );
+            }
+            current->values.push_back( std::move( value ) );
+        }
+        ++size;
+    }
+
+    void set( std::size_t index, Value value, bool transient )
+    {
+        auto current = &edit( root, transient );
+        for( auto level = shift; level > 0; level -= bits )
+        {
+            current = &edit( current->children[ ( index >> level ) & mask ], transient );
+        }
+        current->values[ index & mask ] = std::move( value );
+    }
+
+    void pop_back( bool transient )
+    {
+        if( 1 == size )
+        {
+            *this = {};
+            return;
+        }
+
+        const auto index = size - 1;
+        pop_back( root, shift, index, transient );
+        --size;
+
+        if( shift > 0 && 1 == root->children.size() )
+        {
+            auto collapsed = root->children.front();
+            root = std::move( collapsed );
+            shift -= bits;
+        }
+    }
+
+    static void pop_back( pointer & slot, std::size_t level, std::size_t index, bool transient )
+    {
+        auto & current = edit( slot, transient );
+        if( 0 == level )
+        {
+            current.values.pop_back();
+            return;
+        }
+
+        const auto child = ( index >> level ) & mask;
+        if( 0 == ( index & ( ( std::size_t( 1 ) << level ) - 1 ) ) )
+        {
+            current.children.pop_back();
+            return;
+        }
+        pop_back( current.children[ child ], level - bits, index, transient );
+    }
+};
+
+}
+
+// Immutable vector, every update returns a new version sharing all untouched nodes with this one
+template< typename Value, thread_policy_e Policy = thread_policy_e::safe >
+class persistent_vector final
+{
+public:
+    using value_type = Value;
+    using size_type = std::size_t;
+    constexpr static thread_policy_e thread_policy = Policy;
+
+public:
+    persistent_vector() = default;
+
+public:
+    [[ nodiscard ]] size_type size() const noexcept
+    {
+        return m_trie.size;
+    }
+
+    [[ nodiscard ]] bool empty() const noexcept
+    {
+        return 0 == m_trie.size;
+    }
+
+    [[ nodiscard ]] const value_type & operator []( size_type index ) const noexcept
+    {
+        assert( index < m_trie.size && "Out of range" );
+        return m_trie.get( index );
+    }
+
+    [[ nodiscard ]] const value_type & at( size_type index ) const
+    {
+        if( index >= m_trie.size )
+        {
+            throw std::out_of_range( "ntsp: persistent_vector index out of range" );
+        }
+        return m_trie.get( index );
+    }
+
+public:
+    [[ nodiscard ]] persistent_vector push_back( value_type value ) const
+    {
+        auto result = *this;
+        result.m_trie.push_back( std::move( value ), false );
+        return result;
+    }
+
+    [[ nodiscard ]] persistent_vector set( size_type index, value_type value ) const
+    {
+        if( index >= m_trie.size )
+        {
+            throw std::out_of_range( "ntsp: persistent_vector index out of range" );
+        }
+
+        auto result = *this;
+        result.m_trie.set( index, std::move( value ), false );
+        return result;
+    }
+
+    [[ nodiscard ]] persistent_vector pop_back() const
+    {
+        assert( m_trie.size && "Empty" );
+        auto result = *this;
+        result.m_trie.pop_back( false );
+        return result;
+    }
+
+    [[ nodiscard ]] transient_vector< value_type, thread_policy > transient() const
+    {
+        return transient_vector< value_type, thread_policy >( m_trie );
+    }
+
+private:
+    friend class transient_vector< value_type, thread_policy >;
+
+    using trie = detail::persistent_vector_trie< value_type, thread_policy >;
+    trie m_trie;
+
+private:
+    explicit persistent_vector( trie trie ) noexcept
+            : m_trie( std::move( trie ) )
+    {
+
+    }
+};
+
+// Batch editing mode, mutates in place every node it owns exclusively
+template< typename Value, thread_policy_e Policy = thread_policy_e::safe >
+class transient_vector final
+{
+public:
+    using value_type = Value;
+    using size_type = std::size_t;
+    constexpr static thread_policy_e thread_policy = Policy;
+
+public:
+    transient_vector() = default;
+
+public:
+    [[ nodiscard ]] size_type size() const noexcept
+    {
+        return m_trie.size;
+    }
+
+    [[ nodiscard ]] const value_type & operator []( size_type index ) const noexcept
+    {
+        assert( index < m_trie.size && "Out of range" );
+        return m_trie.get( index );
+    }
+
+    void push_back( value_type value )
+    {
+        m_trie.push_back( std::move( value ), true );
+    }
+
+    void set( size_type index, value_type value )
+    {
+        if( index >= m_trie.size )
+        {
+            throw std::out_of_range( "ntsp: transient_vector index out of range" );
+        }
+        m_trie.set( index, std::move( value ), true );
+    }
+
+    void pop_back()
+    {
+        assert( m_trie.size && "Empty" );
+        m_trie.pop_back( true );
+    }
+
+    // Snapshot, further edits of this transient copy the nodes shared with it
+    [[ nodiscard ]] persistent_vector< value_type, thread_policy > persistent() const
+    {
+        return persistent_vector< value_type, thread_policy >( m_trie );
+    }
+
+private:
+    friend class persistent_vector< value_type, thread_policy >;
+
+    using trie = detail::persistent_vector_trie< value_type, thread_policy >;
+    trie m_trie;
+
+private:
+    explicit transient_vector( trie trie ) noexcept
+            : m_trie( std::move( trie ) )
+    {
+
+    }
+};
+
+}
@@ -1,10 +1,15 @@
 #pragma once
 
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
 #include <type_traits>
 #include <mutex>
 #include <atomic>
 
 #include <ntsp/types.h>
+#include <ntsp/arena.h>
 
 #ifndef NTSP_REFERENCE_COUNTER_TYPE
 #define NTSP_REFERENCE_COUNTER_TYPE std::size_t
@@ -24,6 +29,18 @@ class enable_shared_from_this;
 template< typename Value, typename ... Args >
 decltype( auto ) make_shared( Args && ... args );
 
+namespace detail {
+
+template< typename Node, thread_policy_e Policy >
+struct graph_builder;
+
+}
+
+template< thread_policy_e Policy >
+class region;
+
+template< thread_policy_e Policy >
+class reference_counter;
 
 namespace detail {
 
@@ -65,6 +82,83 @@ struct reference_counter_thread_guard< thread_policy_e::unsafe >
     }
 };
 
+// Biased counters lock only for weak references, strong ones follow the protocol below
+template<>
+struct reference_counter_thread_guard< thread_policy_e::biased > : reference_counter_thread_guard< thread_policy_e::safe >
+{
+};
+
+// Record of the biased counters owned by one thread. Other threads queue a counter here once their part
+// of its strong count goes negative, since only the owner knows whether that made the total zero.
+// The owner merges queued counters when it creates a new one, on process_biased_releases() and on exit,
+// after that whoever queues a counter merges it on the spot.
+class biased_owner final
+{
+public:
+    using counter_type = reference_counter< thread_policy_e::biased >;
+
+public:
+    [[ nodiscard ]] static biased_owner * current() noexcept
+    {
+        return s_current;
+    }
+
+    [[ nodiscard ]] static biased_owner * acquire_current() noexcept
+    {
+        if( ! s_current )
+        {
+            s_current = new biased_owner();
+            thread_local exit_guard guard;
+        }
+        s_current->m_references.fetch_add( 1, std::memory_order_relaxed );
+        return s_current;
+    }
+
+    void release() noexcept
+    {
+        if( 1 == m_references.fetch_sub( 1, std::memory_order_acq_rel ) )
+        {
+            delete this;
+        }
+    }
+
+    [[ nodiscard ]] bool has_queued() const noexcept
+    {
+        return m_queue.load( std::memory_order_relaxed ) != nullptr;
+    }
+
+    inline void enqueue( counter_type * counter ) noexcept;
+    inline void process() noexcept;
+
+private:
+    struct exit_guard final
+    {
+        inline ~exit_guard();
+    };
+
+    std::atomic< counter_type * > m_queue{ nullptr };
+    std::atomic_size_t m_references{ 1 };
+    std::atomic_bool m_orphaned{ false };
+
+    inline static constinit thread_local biased_owner * s_current = nullptr;
+};
+
+template< thread_policy_e Policy >
+struct biased_state final
+{
+};
+
+template<>
+struct biased_state< thread_policy_e::biased > final
+{
+    biased_owner * owner = nullptr;
+    std::atomic< std::intptr_t > shared{ 0 };
+    bool merged = false;
+    reference_counter< thread_policy_e::biased > * next = nullptr;
+    void * value = nullptr;
+    void ( * release )( void * counter, void * value ) noexcept = nullptr;
+};
+
 }
 
 template< thread_policy_e Policy >
@@ -79,36 +173,228 @@ class reference_counter final
         empty, non_empty
     };
 
+    enum class allocation_e : uint8_t
+    {
+        separate, monotonic, arena, region
+    };
+
 private:
     using thread_guard = detail::reference_counter_thread_guard< thread_policy >;
     using lock = std::lock_guard< thread_guard >;
 
 private:
-    explicit reference_counter( bool monotonicAllocated ) noexcept
-            : m_monotonic_allocated( monotonicAllocated )
-            , m_strong( 0 )
+    explicit reference_counter( allocation_e allocation ) noexcept
+            : m_strong( 0 )
             , m_weak( 0 )
+            , m_allocation( allocation )
     {
+        if constexpr( thread_policy == thread_policy_e::biased )
+        {
+            m_biased.owner = detail::biased_owner::acquire_current();
+            if( m_biased.owner->has_queued() )
+            {
+                m_biased.owner->process();
+            }
+        }
+    }
+
+    ~reference_counter() requires( thread_policy != thread_policy_e::biased ) = default;
 
+    ~reference_counter() requires( thread_policy == thread_policy_e::biased )
+    {
+        m_biased.owner->release();
     }
 
     [[ nodiscard ]] bool is_monotonic_allocated() const noexcept
     {
-        return m_monotonic_allocated;
+        return m_allocation != allocation_e::separate;
+    }
+
+    [[ nodiscard ]] bool is_region_allocated() const noexcept
+    {
+        return m_allocation == allocation_e::region;
+    }
+
+    [[ nodiscard ]] detail::arena * owner_arena() const noexcept
+    {
+        assert( m_allocation == allocation_e::arena && "Not an arena slot" );
+        return *reinterpret_cast< detail::arena * const * >( reinterpret_cast< const char * >( this ) - sizeof( detail::arena * ) );
+    }
+
+    static void deallocate( reference_counter * counter ) noexcept
+    {
+        switch( counter->m_allocation )
+        {
+            case allocation_e::separate:
+                delete counter;
+                break;
+
+            case allocation_e::monotonic:
+                counter->~reference_counter();
+                std::free( counter );
+                break;
+
+            case allocation_e::arena:
+            {
+                const auto owner = counter->owner_arena();
+                counter->~reference_counter();
+                owner->release();
+                break;
+            }
+
+            case allocation_e::region:
+                break;
+        }
     }
 
 private:
     void add_strong() noexcept
     {
-        add( m_strong );
+        if constexpr( thread_policy == thread_policy_e::biased )
+        {
+            if( is_biased_owner() )
+            {
+                ++m_strong;
+                return;
+            }
+            m_biased.shared.fetch_add( shared_one, std::memory_order_relaxed );
+        }
+        else
+        {
+            add( m_strong );
+        }
+    }
+    [[ nodiscard ]] state_e add_strong_if_non_empty() noexcept
+    {
+        if constexpr( thread_policy == thread_policy_e::biased )
+        {
+            // Until merged, the owner part is above zero and nobody could have seen the total reach it
+            if( is_biased_owner() )
+            {
+                ++m_strong;
+                return state_e::non_empty;
+            }
+
+            auto word = m_biased.shared.load( std::memory_order_relaxed );
+            do
+            {
+                if( ( word & merged_flag ) && shared_count( word ) <= 0 )
+                {
+                    return state_e::empty;
+                }
+            }
+            while( ! m_biased.shared.compare_exchange_weak( word, word + shared_one, std::memory_order_acquire, std::memory_order_relaxed ) );
+            return state_e::non_empty;
+        }
+
+        lock lock( m_thread_guard );
+        if( 0 == m_strong )
+        {
+            return state_e::empty;
+        }
+        ++m_strong;
+        return state_e::non_empty;
     }
     [[ nodiscard ]] state_e remove_and_test_strong_empty() noexcept
     {
-        return remove_and_test_empty( m_strong );
+        if constexpr( thread_policy == thread_policy_e::biased )
+        {
+            return remove_and_test_strong_empty( 1 );
+        }
+        else
+        {
+            return remove_and_test_empty( m_strong );
+        }
+    }
+    [[ nodiscard ]] state_e remove_and_test_strong_empty( counter count ) noexcept
+    {
+        if constexpr( thread_policy == thread_policy_e::biased )
+        {
+            if( is_biased_owner() )
+            {
+                assert( m_strong >= count && "Owner released more than it added" );
+                m_strong -= count;
+                return 0 == m_strong ? merge( false ) : state_e::non_empty;
+            }
+
+            auto word = m_biased.shared.load( std::memory_order_relaxed );
+            std::intptr_t next;
+            bool enqueue;
+            do
+            {
+                next = word - static_cast< std::intptr_t >( count ) * shared_one;
+                enqueue = ! ( word & ( merged_flag | queued_flag ) ) && shared_count( next ) < 0;
+                if( enqueue )
+                {
+                    next |= queued_flag;
+                }
+            }
+            while( ! m_biased.shared.compare_exchange_weak( word, next, std::memory_order_acq_rel, std::memory_order_relaxed ) );
+
+            if( enqueue )
+            {
+                m_biased.owner->enqueue( this );
+                return state_e::non_empty;
+            }
+            return is_merged_empty( next ) ? state_e::empty : state_e::non_empty;
+        }
+
+        lock lock( m_thread_guard );
+        if( m_strong <= count )
+        {
+            m_strong = 0;
+            return state_e::empty;
+        }
+        m_strong -= count;
+        return state_e::non_empty;
     }
     [[ nodiscard ]] state_e test_strong() const noexcept
     {
-        return test( m_strong );
+        if constexpr( thread_policy == thread_policy_e::biased )
+        {
+            if( is_biased_owner() )
+            {
+                return state_e::non_empty;
+            }
+            return is_merged_empty( m_biased.shared.load( std::memory_order_acquire ) ) ? state_e::empty : state_e::non_empty;
+        }
+        else
+        {
+            return test( m_strong );
+        }
+    }
+    [[ nodiscard ]] counter strong_count() const noexcept
+    {
+        if constexpr( thread_policy == thread_policy_e::biased )
+        {
+            const auto word = m_biased.shared.load( std::memory_order_acquire );
+            const auto shared = shared_count( word );
+            if( is_biased_owner() )
+            {
+                return static_cast< counter >( static_cast< std::intptr_t >( m_strong ) + shared );
+            }
+            if( word & merged_flag )
+            {
+                return static_cast< counter >( std::max< std::intptr_t >( shared, 0 ) );
+            }
+
+            // The owner part is unknown here, report the value as shared rather than exclusive
+            return static_cast< counter >( std::max< std::intptr_t >( shared + 1, 2 ) );
+        }
+        else
+        {
+            lock lock( m_thread_guard );
+            return m_strong;
+        }
+    }
+
+    void set_release_hook( void * value, void ( * release )( void * counter, void * value ) noexcept ) noexcept
+    {
+        if constexpr( thread_policy == thread_policy_e::biased )
+        {
+            m_biased.value = value;
+            m_biased.release = release;
+        }
     }
 
     void add_weak() noexcept
@@ -124,6 +410,20 @@ private:
         return test( m_weak );
     }
 
+    // Region teardown hands a weakly referenced counter over to its arena under the guard,
+    // so the last weak release either sees the switch or has already left nothing to hand over
+    [[ nodiscard ]] state_e move_to_arena_if_weak() noexcept
+    {
+        lock lock( m_thread_guard );
+        if( 0 == m_weak )
+        {
+            return state_e::empty;
+        }
+        m_allocation = allocation_e::arena;
+        owner_arena()->acquire();
+        return state_e::non_empty;
+    }
+
 private:
     template< typename V, thread_policy_e P >
     friend class weak_pointer;
@@ -137,11 +437,88 @@ private:
     template< typename V, typename ... Args >
     friend decltype( auto ) make_shared( Args && ... args );
 
+    template< typename N, thread_policy_e P >
+    friend struct detail::graph_builder;
+
+    friend class region< thread_policy >;
+
+    friend class detail::biased_owner;
+
 private:
+    // Under the biased policy m_strong is the owner part of the strong count, touched by the owner thread only
     counter m_strong;
     counter m_weak;
-    const bool m_monotonic_allocated;
+    allocation_e m_allocation;
     mutable thread_guard m_thread_guard;
+    [[ no_unique_address ]] detail::biased_state< thread_policy > m_biased;
+
+private:
+    // Shared part of a biased strong count, the two low bits flag merged and queued counters
+    constexpr static std::intptr_t merged_flag = 1;
+    constexpr static std::intptr_t queued_flag = 2;
+    constexpr static std::intptr_t shared_one = 4;
+
+    [[ nodiscard ]] static std::intptr_t shared_count( std::intptr_t word ) noexcept
+    {
+        return word >> 2;
+    }
+
+    [[ nodiscard ]] static bool is_merged_empty( std::intptr_t word ) noexcept
+    {
+        return ( word & merged_flag ) && ! ( word & queued_flag ) && 0 == shared_count( word );
+    }
+
+    [[ nodiscard ]] bool is_biased_owner() const noexcept requires( thread_policy == thread_policy_e::biased )
+    {
+        return m_biased.owner == detail::biased_owner::current() && ! m_biased.merged;
+    }
+
+    // Moves the owner part into the shared one, from then on every thread counts atomically.
+    // A queued counter is left for the queue to release, unless this is the queue processing it.
+    [[ nodiscard ]] state_e merge( bool dequeue ) noexcept requires( thread_policy == thread_policy_e::biased )
+    {
+        const auto biased = static_cast< std::intptr_t >( m_strong );
+        m_strong = 0;
+        m_biased.merged = true;
+
+        auto word = m_biased.shared.load( std::memory_order_relaxed );
+        std::intptr_t next;
+        do
+        {
+            next = ( word + biased * shared_one ) | merged_flag;
+            if( dequeue )
+            {
+                next &= ~queued_flag;
+            }
+        }
+        while( ! m_biased.shared.compare_exchange_weak( word, next, std::memory_order_acq_rel, std::memory_order_relaxed ) );
+
+        return is_merged_empty( next ) ? state_e::empty : state_e::non_empty;
+    }
+
+    void merge_queued() noexcept requires( thread_policy == thread_policy_e::biased )
+    {
+        auto state = state_e::non_empty;
+        if( ! m_biased.merged )
+        {
+            state = merge( true );
+        }
+        else
+        {
+            // Cleared even when the count is zero, so the counter reads as expired once its value is gone
+            auto word = m_biased.shared.load( std::memory_order_acquire );
+            while( ! m_biased.shared.compare_exchange_weak( word, word & ~queued_flag, std::memory_order_acq_rel, std::memory_order_acquire ) )
+            {
+
+            }
+            state = is_merged_empty( word & ~queued_flag ) ? state_e::empty : state_e::non_empty;
+        }
+
+        if( state == state_e::empty )
+        {
+            m_biased.release( this, m_biased.value );
+        }
+    }
 
 private:
     [[ nodiscard ]] state_e remove_and_test_empty( counter & counter ) noexcept
@@ -174,4 +551,63 @@ private:
     }
 };
 
-}
\ No newline at end of file
+namespace detail {
+
+void biased_owner::enqueue( counter_type * counter ) noexcept
+{
+    auto head = m_queue.load( std::memory_order_relaxed );
+    do
+    {
+        counter->m_biased.next = head;
+    }
+    while( ! m_queue.compare_exchange_weak( head, counter, std::memory_order_seq_cst, std::memory_order_relaxed ) );
+
+    // Either the exiting owner sees this counter in its last pass, or this thread sees it has exited
+    if( m_orphaned.load( std::memory_order_seq_cst ) )
+    {
+        m_references.fetch_add( 1, std::memory_order_relaxed );
+        process();
+        release();
+    }
+}
+
+void biased_owner::process() noexcept
+{
+    auto head = m_queue.exchange( nullptr, std::memory_order_seq_cst );
+    while( head )
+    {
+        const auto next = head->m_biased.next;
+        head->merge_queued();
+        head = next;
+    }
+}
+
+biased_owner::exit_guard::~exit_guard()
+{
+    const auto owner = s_current;
+    owner->process();
+
+    s_current = nullptr;
+    owner->m_orphaned.store( true, std::memory_order_seq_cst );
+    owner->process();
+    owner->release();
+}
+
+}
+
+// Merges biased counters other threads queued for this one, values nobody refers to anymore die here
+inline void process_biased_releases() noexcept
+{
+    if( const auto owner = detail::biased_owner::current() )
+    {
+        owner->process();
+    }
+}
+
+#ifndef NTSP_NO_EXTERN_TEMPLATES
+extern template class reference_counter< thread_policy_e::safe >;
+extern template class reference_counter< thread_policy_e::unsafe >;
+extern template class reference_counter< thread_policy_e::biased >;
+#endif
+
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <ntsp/arena.h>
+#include <ntsp/shared_pointer.h>
+
+namespace ntsp {
+
+// Bump allocates reference counters and values for one unit of work.
+// Counters inside a region never free memory on their own, the region releases every chunk at once
+// when it is destroyed, after running destructors of values still alive, e.g. ones kept by reference cycles.
+// Weak pointers may outlive the region and report expired, shared pointers may not.
+// Allocation is not synchronized, counting follows the thread policy. A biased region is destroyed on the thread
+// that allocated from it, which merges what other threads released first.
+template< thread_policy_e Policy = thread_policy_e::safe >
+class region final
+{
+public:
+    constexpr static thread_policy_e thread_policy = Policy;
+    constexpr static std::size_t default_chunk_size = 64 * 1024;
+
+public:
+    explicit region( std::size_t chunk_size = default_chunk_size ) noexcept
+            : m_chunk_size( chunk_size )
+    {
+
+    }
+
+    region( const region & ) = delete;
+    region & operator =( const region & ) = delete;
+
+    ~region()
+    {
+        teardown();
+    }
+
+public:
+    template< typename Value, typename ... Args >
+    [[ nodiscard ]] shared_pointer< Value, thread_policy > make( Args && ... args )
+    {
+        using slot_type = slot< Value >;
+        static_assert( offsetof( slot_type, counter ) - offsetof( slot_type, owner ) == sizeof( detail::arena * ), "Counter must follow its arena pointer" );
+        static_assert( alignof( slot_type ) <= alignof( std::max_align_t ), "Over-aligned values are not supported" );
+        static_assert( ! is_compact_enable_shared_from_this_v< Value, thread_policy >
+                       || offsetof( slot_type, value ) - offsetof( slot_type, counter ) == sizeof( slot_type::counter ), "Value must follow its counter" );
+
+        const auto memory = static_cast< slot_type * >( allocate( sizeof( slot_type ), alignof( slot_type ) ) );
+        const auto value = ::new( &memory->value ) Value( std::forward< Args >( args )... );
+
+        memory->header.previous = m_last;
+        memory->header.destroy = &destroy_value< Value >;
+        memory->owner = m_chunks.back();
+        memory->header.counter = new( &memory->counter ) reference_counter_t( reference_counter_t::allocation_e::region );
+        m_last = &memory->header;
+
+        return shared_pointer< Value, thread_policy >::from_created( memory->header.counter, value );
+    }
+
+private:
+    using reference_counter_t = reference_counter< thread_policy >;
+
+    struct entry final
+    {
+        entry * previous;
+        void ( * destroy )( entry * ) noexcept;
+        reference_counter_t * counter;
+        bool held;
+    };
+
+    template< typename Value >
+    struct slot final
+    {
+        entry header;
+        detail::arena * owner;
+        std::aligned_storage_t< sizeof( reference_counter_t ), alignof( reference_counter_t ) > counter;
+        std::aligned_storage_t< sizeof( Value ), alignof( Value ) > value;
+    };
+
+private:
+    const std::size_t m_chunk_size;
+    std::vector< detail::arena * > m_chunks;
+    char * m_cursor = nullptr;
+    char * m_end = nullptr;
+    entry * m_last = nullptr;
+
+private:
+    template< typename Value >
+    static void destroy_value( entry * entry ) noexcept
+    {
+        reinterpret_cast< Value * >( &reinterpret_cast< slot< Value > * >( entry )->value )->~Value();
+    }
+
+    void * allocate( std::size_t size, std::size_t alignment )
+    {
+        auto address = align( m_cursor, alignment );
+        if( ! m_cursor || address + size > m_end )
+        {
+            const auto chunk_size = std::max( m_chunk_size, size );
+            m_chunks.reserve( m_chunks.size() + 1 );
+            m_chunks.push_back( detail::arena::create( 1, chunk_size ) );
+
+            m_cursor = static_cast< char * >( m_chunks.back()->slot( 0 ) );
+            m_end = m_cursor + chunk_size;
+            address = align( m_cursor, alignment );
+        }
+
+        m_cursor = address + size;
+        return address;
+    }
+
+    static char * align( char * address, std::size_t alignment ) noexcept
+    {
+        const auto value = reinterpret_cast< std::uintptr_t >( address );
+        return reinterpret_cast< char * >( ( value + alignment - 1 ) / alignment * alignment );
+    }
+
+    void teardown() noexcept
+    {
+        if constexpr( thread_policy == thread_policy_e::biased )
+        {
+            // Counters other threads queued still read as held to their owner, merged here they leave the queue before their chunk goes
+            process_biased_releases();
+        }
+
+        for( auto current = m_last; current; current = current->previous )
+        {
+            if constexpr( thread_policy == thread_policy_e::biased )
+            {
+                assert( current->counter->m_biased.owner == detail::biased_owner::current() && "Biased region destroyed off its owner thread" );
+            }
+            current->held = current->counter->test_strong() == reference_counter_t::state_e::non_empty;
+            if( current->held )
+            {
+                current->counter->add_strong();
+            }
+        }
+
+        for( auto current = m_last; current; current = current->previous )
+        {
+            if( current->held )
+            {
+                current->destroy( current );
+            }
+        }
+
+        for( auto current = m_last; current; current = current->previous )
+        {
+            const auto counter = current->counter;
+            if( current->held )
+            {
+                [[ maybe_unused ]] const auto state = counter->remove_and_test_strong_empty();
+                assert( state == reference_counter_t::state_e::empty && "Shared pointer outlived its region" );
+            }
+
+            if( counter->move_to_arena_if_weak() == reference_counter_t::state_e::empty )
+            {
+                counter->~reference_counter_t();
+            }
+        }
+
+        for( const auto chunk : m_chunks )
+        {
+            chunk->release();
+        }
+    }
+};
+
+template< typename Value, thread_policy_e Policy, typename ... Args >
+[[ nodiscard ]] shared_pointer< Value, Policy > make_in( region< Policy > & region, Args && ... args )
+{
+    return region.template make< Value >( std::forward< Args >( args )... );
+}
+
+}
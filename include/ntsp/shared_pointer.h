@@ -4,8 +4,13 @@
 
 #include <ntsp/traits.h>
 #include <ntsp/reference_counter.h>
+#include <ntsp/deferred_release.h>
 #include <memory>
 
+#ifndef NTSP_SPLIT_ALLOCATION_THRESHOLD
+#define NTSP_SPLIT_ALLOCATION_THRESHOLD 1024
+#endif
+
 namespace ntsp {
 namespace detail {
 
@@ -68,7 +73,7 @@ template< typename SharedPointerConfig >
 concept shared_pointer_config =
 requires {
     typename SharedPointerConfig::value_type;
-    SharedPointerConfig::thread_policy -> convertible_to< thread_policy_e >;
+    { SharedPointerConfig::thread_policy } -> convertible_to< thread_policy_e >;
 };
 
 template< typename Value, thread_policy_e Policy = thread_policy_e::safe >
@@ -80,36 +85,72 @@ public:
     constexpr static thread_policy_e thread_policy = Policy;
 
 public:
-    template< typename ... Args >
+    // Values larger than the threshold get their own allocation, released as soon as the last strong
+    // reference is gone, instead of sharing one block with the counter until the last weak one is gone
+    template< allocation_layout_e Layout = allocation_layout_e::automatic, typename ... Args >
     static decltype( auto ) make( Args && ... args )
     {
-        constexpr static std::size_t reference_counter_size = sizeof( std::aligned_storage_t< sizeof( reference_counter_t ), alignof( reference_counter_t ) > );
-        constexpr static std::size_t storage_size = sizeof( std::aligned_storage_t< sizeof( value_type ), alignof( value_type ) > );
+        constexpr auto compact = is_compact_enable_shared_from_this_v< value_type, thread_policy >;
+        static_assert( ! compact || Layout != allocation_layout_e::split, "Compact shared from this finds the counter in the single block" );
 
-        const auto memory = static_cast< char * >( std::malloc( reference_counter_size + storage_size ) );
-        if( ! memory )
+        constexpr auto layout = Layout != allocation_layout_e::automatic ? Layout
+                                : ! compact && sizeof( value_type ) > NTSP_SPLIT_ALLOCATION_THRESHOLD ? allocation_layout_e::split
+                                : allocation_layout_e::single_block;
+        if constexpr( layout == allocation_layout_e::split )
         {
-            throw std::bad_alloc();
+            const auto value = new value_type( std::forward< Args >( args )... );
+            try
+            {
+                return from_created( new reference_counter_t( reference_counter_t::allocation_e::separate ), value );
+            }
+            catch( ... )
+            {
+                delete value;
+                throw;
+            }
+        }
+        else
+        {
+            constexpr static std::size_t storage_size = sizeof( std::aligned_storage_t< sizeof( value_type ), alignof( value_type ) > );
+
+            const auto memory = static_cast< char * >( std::malloc( reference_counter_size + storage_size ) );
+            if( ! memory )
+            {
+                throw std::bad_alloc();
+            }
+
+            const auto counter = new( memory ) reference_counter_t( reference_counter_t::allocation_e::monotonic );
+            try
+            {
+                const auto value = ::new( memory + reference_counter_size ) value_type( std::forward< Args >( args )... );
+                return from_created( counter, value );
+            }
+            catch( ... )
+            {
+                reference_counter_t::deallocate( counter );
+                throw;
+            }
         }
-
-        const auto counter = new( memory ) reference_counter_t( true );
-        const auto value = new( memory + reference_counter_size ) value_type( std::forward< Args ... >( args ... ) );
-        return shared_pointer< value_type, thread_policy >( counter, value );
     }
 
 public:
-    shared_pointer()
-            : m_reference_counter( new reference_counter_t( false ) )
+    shared_pointer() noexcept
+            : m_reference_counter( nullptr )
             , m_storage( nullptr )
     {
-        process_shared_from_this( shared_pointer::m_storage, this );
+
     }
 
     explicit shared_pointer( value_type * value )
-            : m_reference_counter( new reference_counter_t( false ) )
-            , m_storage( reinterpret_cast< storage_t * >( value ) )
+            : m_reference_counter( value ? new reference_counter_t( reference_counter_t::allocation_e::separate ) : nullptr )
+            , m_storage( value )
     {
-        m_reference_counter->add_strong();
+        if( m_reference_counter )
+        {
+            m_reference_counter->add_strong();
+            m_reference_counter->set_release_hook( m_storage, &release_merged );
+            adopt_shared_from_this();
+        }
     }
 
     ~shared_pointer()
@@ -139,7 +180,10 @@ public:
             return *this;
         }
 
-        delete_counter_and_storage();
+        if( m_reference_counter )
+        {
+            delete_counter_and_storage();
+        }
 
         m_reference_counter = other.m_reference_counter;
         if( m_reference_counter )
@@ -165,7 +209,10 @@ public:
             return *this;
         }
 
-        delete_counter_and_storage();
+        if( m_reference_counter )
+        {
+            delete_counter_and_storage();
+        }
 
         m_reference_counter = other.m_reference_counter;
         m_storage = other.m_storage;
@@ -179,7 +226,7 @@ public:
 public:
     [[nodiscard]] inline value_type * get() const noexcept
     {
-        return reinterpret_cast< value_type * >( m_storage );
+        return m_storage;
     }
 
     [[nodiscard]] inline bool empty() const noexcept
@@ -187,6 +234,11 @@ public:
         return nullptr == m_storage;
     }
 
+    [[nodiscard]] std::size_t use_count() const noexcept
+    {
+        return m_reference_counter ? static_cast< std::size_t >( m_reference_counter->strong_count() ) : 0;
+    }
+
     explicit inline operator bool() const noexcept
     {
         return empty();
@@ -224,81 +276,166 @@ private:
 
     friend class enable_shared_from_this< value_type, thread_policy >;
 
+    friend class compact_enable_shared_from_this< value_type, thread_policy >;
+
     template< typename V, typename ... Args >
     friend decltype( auto ) make_shared( Args && ... args );
 
+    template< typename N, thread_policy_e P >
+    friend struct detail::graph_builder;
+
+    friend class region< thread_policy >;
+
 private:
     using reference_counter_t = reference_counter< thread_policy >;
+    constexpr static std::size_t reference_counter_size = sizeof( std::aligned_storage_t< sizeof( reference_counter_t ), alignof( reference_counter_t ) > );
+
     reference_counter_t * m_reference_counter;
 
-    using storage_t = std::aligned_storage_t< sizeof( value_type ), alignof( value_type ) >;
-    storage_t * m_storage;
+    value_type * m_storage;
 
 private:
     explicit shared_pointer( reference_counter_t * reference_counter, value_type * value ) noexcept
             : m_reference_counter( reference_counter )
-            , m_storage( reinterpret_cast< storage_t * >( value ) )
+            , m_storage( value )
     {
         m_reference_counter->add_strong();
-        process_shared_from_this( get(), this );
+    }
+
+    // First pointer to a counter created just now, the only place the value and its counter are wired together,
+    // so pointers made later from shared_from_this() write nothing other threads may be reading
+    [[ nodiscard ]] static shared_pointer from_created( reference_counter_t * reference_counter, value_type * value ) noexcept
+    {
+        reference_counter->set_release_hook( value, &release_merged );
+        auto result = shared_pointer( reference_counter, value );
+        process_shared_from_this( value, &result );
+        return result;
+    }
+
+private:
+    struct adopt_t final
+    {
+    };
+
+    explicit shared_pointer( adopt_t, reference_counter_t * reference_counter, value_type * value ) noexcept
+            : m_reference_counter( reference_counter )
+            , m_storage( value )
+    {
+
     }
 
 private:
     void delete_counter_and_storage()
     {
         assert( m_reference_counter && "Already moved" );
-        if( m_reference_counter->remove_and_test_strong_empty() == reference_counter_t::state_e::non_empty )
+        if constexpr( thread_policy == thread_policy_e::safe )
+        {
+            // A region may be gone before the buffer is flushed, its counters are released right away
+            const auto buffer = detail::deferred_release_buffer::current;
+            if( buffer && ! m_reference_counter->is_region_allocated() )
+            {
+                buffer->defer( m_reference_counter, m_storage, &release_deferred );
+                return;
+            }
+        }
+
+        release( m_reference_counter, m_storage, 1 );
+    }
+
+    static void release( reference_counter_t * reference_counter, value_type * value, std::size_t count ) noexcept
+    {
+        if( reference_counter->remove_and_test_strong_empty( count ) == reference_counter_t::state_e::non_empty )
         {
             return;
         }
 
-        if( m_reference_counter->is_monotonic_allocated() )
+        destroy( reference_counter, value );
+    }
+
+    static void destroy( reference_counter_t * reference_counter, value_type * value ) noexcept
+    {
+        if( reference_counter->is_monotonic_allocated() )
         {
-            get()->~value_type();
+            value->~value_type();
         }
         else
         {
-            delete m_storage;
+            if constexpr( is_compact_enable_shared_from_this_v< value_type, thread_policy > )
+            {
+                compact_enable_shared_from_this< value_type, thread_policy >::forget( value );
+            }
+            delete value;
         }
-        m_storage = nullptr;
 
-        if( m_reference_counter->test_weak() == reference_counter_t::state_e::non_empty )
+        if( reference_counter->test_weak() == reference_counter_t::state_e::non_empty )
         {
             return;
         }
 
-        if( m_reference_counter->is_monotonic_allocated() )
-        {
-            m_reference_counter->~reference_counter();
-            std::free( m_reference_counter );
-        }
-        else
-        {
-            delete m_reference_counter;
-        }
-        m_reference_counter = nullptr;
+        reference_counter_t::deallocate( reference_counter );
+    }
+
+    static void release_deferred( void * reference_counter, void * value, std::size_t count ) noexcept
+    {
+        release( static_cast< reference_counter_t * >( reference_counter ), static_cast< value_type * >( value ), count );
+    }
+
+    // Biased counters found empty while merging a queue, the strong count is already gone
+    static void release_merged( void * reference_counter, void * value ) noexcept
+    {
+        destroy( static_cast< reference_counter_t * >( reference_counter ), static_cast< value_type * >( value ) );
     }
 
     static void process_shared_from_this( value_type * value, shared_pointer< value_type, thread_policy > * self )
     {
         if constexpr( is_enable_shared_from_this_v< value_type, thread_policy > )
         {
-            const auto shared_from_this = reinterpret_cast< enable_shared_from_this< value_type, thread_policy > * >( value );
+            const auto shared_from_this = static_cast< enable_shared_from_this< value_type, thread_policy > * >( value );
             shared_from_this->m_reference_counter = self->m_reference_counter;
         }
     }
+
+    // Compact values keep nothing, those not placed behind their counter are registered by address instead
+    void adopt_shared_from_this()
+    {
+        if constexpr( is_compact_enable_shared_from_this_v< value_type, thread_policy > )
+        {
+            try
+            {
+                compact_enable_shared_from_this< value_type, thread_policy >::adopt( m_storage, m_reference_counter );
+            }
+            catch( ... )
+            {
+                delete m_reference_counter;
+                throw;
+            }
+        }
+        else
+        {
+            process_shared_from_this( get(), this );
+        }
+    }
 };
 
 template< typename Value, thread_policy_e Policy, typename ... Args >
 decltype( auto ) make_shared( Args && ... args )
 {
-    return shared_pointer< Value, Policy >::make( std::forward< Args ... >( args ... ) );
+    return shared_pointer< Value, Policy >::make( std::forward< Args >( args )... );
 }
 
 template< typename Value, typename ... Args >
 decltype( auto ) make_shared( Args && ... args )
 {
-    return make_shared< Value, thread_policy_e::safe >( std::forward< Args ... >( args ... ) );
+    return make_shared< Value, thread_policy_e::safe >( std::forward< Args >( args )... );
 }
 
-}
\ No newline at end of file
+#ifndef NTSP_NO_EXTERN_TEMPLATES
+#define NTSP_EXTERN_SHARED_POINTER( Value ) \
+    extern template class shared_pointer< Value, thread_policy_e::safe >; \
+    extern template class shared_pointer< Value, thread_policy_e::unsafe >; \
+    extern template class shared_pointer< Value, thread_policy_e::biased >;
+NTSP_FOR_EACH_COMMON_VALUE_TYPE( NTSP_EXTERN_SHARED_POINTER )
+#undef NTSP_EXTERN_SHARED_POINTER
+#endif
+
+}
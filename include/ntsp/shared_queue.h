@@ -0,0 +1,136 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+
+#include <ntsp/hazard_pointers.h>
+#include <ntsp/shared_pointer.h>
+
+namespace ntsp {
+
+// Lock-free multi producer, multi consumer queue of shared pointers, after Michael and Scott.
+// Pointers are moved in and out of the nodes, so their reference counters are not touched on the way.
+// The head is always a dummy node, a pop takes the value out of the node after it and makes that the dummy.
+// Popped nodes are reclaimed through hazard pointers, which also rules out ABA on head and tail.
+template< typename Value, thread_policy_e Policy = thread_policy_e::safe >
+class shared_queue final
+{
+public:
+    using value_type = Value;
+    using pointer_type = shared_pointer< value_type, Policy >;
+    constexpr static thread_policy_e thread_policy = Policy;
+
+public:
+    shared_queue()
+            : m_head( new node() )
+            , m_tail( m_head.load( std::memory_order_relaxed ) )
+    {
+
+    }
+
+    shared_queue( const shared_queue & ) = delete;
+    shared_queue & operator =( const shared_queue & ) = delete;
+
+    ~shared_queue()
+    {
+        auto current = m_head.load( std::memory_order_acquire );
+        while( current )
+        {
+            const auto next = current->next.load( std::memory_order_relaxed );
+            delete current;
+            current = next;
+        }
+    }
+
+public:
+    void push( pointer_type value )
+    {
+        assert( ! value.empty() && "Empty pointers are indistinguishable from an empty queue" );
+
+        const auto added = new node{ std::move( value ) };
+        auto & hazards = detail::hazard_pointers::local();
+        for( ;; )
+        {
+            auto tail = hazards.protect( 0, m_tail );
+            auto next = tail->next.load( std::memory_order_acquire );
+            if( tail != m_tail.load( std::memory_order_acquire ) )
+            {
+                continue;
+            }
+
+            // A lagging tail is moved on by whoever notices it
+            if( next )
+            {
+                m_tail.compare_exchange_weak( tail, next, std::memory_order_release, std::memory_order_relaxed );
+                continue;
+            }
+
+            if( tail->next.compare_exchange_weak( next, added, std::memory_order_release, std::memory_order_relaxed ) )
+            {
+                m_tail.compare_exchange_strong( tail, added, std::memory_order_release, std::memory_order_relaxed );
+                break;
+            }
+        }
+        hazards.clear( 0 );
+    }
+
+    // Returns an empty pointer when the queue is empty
+    [[ nodiscard ]] pointer_type pop()
+    {
+        auto & hazards = detail::hazard_pointers::local();
+        for( ;; )
+        {
+            auto head = hazards.protect( 0, m_head );
+            auto tail = m_tail.load( std::memory_order_acquire );
+            const auto next = hazards.protect( 1, head->next );
+            if( head != m_head.load( std::memory_order_acquire ) )
+            {
+                continue;
+            }
+
+            if( ! next )
+            {
+                hazards.clear( 0 );
+                hazards.clear( 1 );
+                return pointer_type();
+            }
+
+            if( head == tail )
+            {
+                m_tail.compare_exchange_weak( tail, next, std::memory_order_release, std::memory_order_relaxed );
+                continue;
+            }
+
+            if( m_head.compare_exchange_weak( head, next, std::memory_order_acq_rel, std::memory_order_relaxed ) )
+            {
+                // Only the winner touches the value, the hazard keeps the new dummy alive meanwhile
+                auto value = std::move( next->value );
+                hazards.clear( 0 );
+                hazards.clear( 1 );
+                hazards.retire( head );
+                return value;
+            }
+        }
+    }
+
+    [[ nodiscard ]] bool empty() const
+    {
+        auto & hazards = detail::hazard_pointers::local();
+        const auto head = hazards.protect( 0, m_head );
+        const auto empty = ! head->next.load( std::memory_order_acquire );
+        hazards.clear( 0 );
+        return empty;
+    }
+
+private:
+    struct node final
+    {
+        pointer_type value;
+        std::atomic< node * > next{ nullptr };
+    };
+
+    std::atomic< node * > m_head;
+    std::atomic< node * > m_tail;
+};
+
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+
+#include <ntsp/hazard_pointers.h>
+#include <ntsp/shared_pointer.h>
+
+namespace ntsp {
+
+// Lock-free multi producer, multi consumer stack of shared pointers.
+// Pointers are moved in and out of the nodes, so their reference counters are not touched on the way.
+// Popped nodes are reclaimed through hazard pointers, which also rules out ABA on the head.
+template< typename Value, thread_policy_e Policy = thread_policy_e::safe >
+class shared_stack final
+{
+public:
+    using value_type = Value;
+    using pointer_type = shared_pointer< value_type, Policy >;
+    constexpr static thread_policy_e thread_policy = Policy;
+
+public:
+    shared_stack() noexcept = default;
+
+    shared_stack( const shared_stack & ) = delete;
+    shared_stack & operator =( const shared_stack & ) = delete;
+
+    ~shared_stack()
+    {
+        auto current = m_head.load( std::memory_order_acquire );
+        while( current )
+        {
+            const auto next = current->next;
+            delete current;
+            current = next;
+        }
+    }
+
+public:
+    void push( pointer_type value )
+    {
+        assert( ! value.empty() && "Empty pointers are indistinguishable from an empty stack" );
+
+        const auto added = new node{ std::move( value ), m_head.load( std::memory_order_relaxed ) };
+        while( ! m_head.compare_exchange_weak( added->next, added, std::memory_order_release, std::memory_order_relaxed ) )
+        {
+
+        }
+    }
+
+    // Returns an empty pointer when the stack is empty
+    [[ nodiscard ]] pointer_type pop()
+    {
+        auto & hazards = detail::hazard_pointers::local();
+        node * head;
+        do
+        {
+            head = hazards.protect( 0, m_head );
+            if( ! head )
+            {
+                hazards.clear( 0 );
+                return pointer_type();
+            }
+        }
+        while( ! m_head.compare_exchange_weak( head, head->next, std::memory_order_acquire, std::memory_order_relaxed ) );
+        hazards.clear( 0 );
+
+        auto value = std::move( head->value );
+        hazards.retire( head );
+        return value;
+    }
+
+    [[ nodiscard ]] bool empty() const noexcept
+    {
+        return ! m_head.load( std::memory_order_acquire );
+    }
+
+private:
+    struct node final
+    {
+        pointer_type value;
+        node * next;
+    };
+
+    std::atomic< node * > m_head{ nullptr };
+};
+
+}
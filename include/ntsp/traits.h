@@ -15,6 +15,9 @@ class weak_pointer;
 template< typename Value, thread_policy_e Policy >
 class enable_shared_from_this;
 
+template< typename Value, thread_policy_e Policy >
+class compact_enable_shared_from_this;
+
 template< typename All,  thread_policy_e Policy  >
 struct is_shared_pointer final : public std::false_type
 {
@@ -49,4 +52,12 @@ struct is_enable_shared_from_this final : public std::is_base_of< enable_shared_
 template < typename Value, thread_policy_e Policy >
 constexpr bool is_enable_shared_from_this_v = is_enable_shared_from_this< Value, Policy >::value;
 
+template< typename Value, thread_policy_e Policy >
+struct is_compact_enable_shared_from_this final : public std::is_base_of< compact_enable_shared_from_this < Value, Policy >, Value >
+{
+};
+
+template < typename Value, thread_policy_e Policy >
+constexpr bool is_compact_enable_shared_from_this_v = is_compact_enable_shared_from_this< Value, Policy >::value;
+
 }
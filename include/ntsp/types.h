@@ -1,10 +1,23 @@
 #pragma once
 
+#include <cstdint>
+
 namespace ntsp {
 
 enum class thread_policy_e : uint8_t
 {
-    safe = 0, unsafe = 1
+    safe = 0, unsafe = 1, biased = 2
+};
+
+enum class allocation_layout_e : uint8_t
+{
+    automatic = 0, single_block = 1, split = 2
 };
 
 }
+
+#ifndef NTSP_NO_EXTERN_TEMPLATES
+#define NTSP_FOR_EACH_COMMON_VALUE_TYPE( X ) \
+    X( bool ) X( char ) X( int ) X( unsigned int ) X( long ) X( unsigned long ) \
+    X( long long ) X( unsigned long long ) X( float ) X( double )
+#endif
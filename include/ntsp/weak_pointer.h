@@ -24,8 +24,10 @@ public:
             : m_reference_counter( shared.m_reference_counter )
             , m_value( shared.get() )
     {
-        assert( m_reference_counter && "Shared was already moved" );
-        m_reference_counter->add_weak();
+        if( m_reference_counter )
+        {
+            m_reference_counter->add_weak();
+        }
     }
 
     weak_pointer( const weak_pointer & other ) noexcept
@@ -89,16 +91,16 @@ public:
 
     [[ nodiscard ]] bool expired() const noexcept
     {
-        return m_reference_counter->test_strong() == reference_counter< thread_policy >::state_e::empty;
+        return ! m_reference_counter || m_reference_counter->test_strong() == reference_counter< thread_policy >::state_e::empty;
     }
 
-    shared_pointer< value_type, thread_policy > lock() noexcept
+    shared_pointer< value_type, thread_policy > lock() const noexcept
     {
-        if( m_reference_counter->test_strong() == reference_counter< thread_policy >::state_e::empty )
+        if( ! m_reference_counter || m_reference_counter->add_strong_if_non_empty() == reference_counter< thread_policy >::state_e::empty )
         {
-            m_value = nullptr;
+            return shared_pointer< value_type, thread_policy >();
         }
-        return shared_pointer< value_type, thread_policy >( m_reference_counter, m_value );
+        return shared_pointer< value_type, thread_policy >( typename shared_pointer< value_type, thread_policy >::adopt_t{}, m_reference_counter, m_value );
     }
 
 private:
@@ -124,17 +126,18 @@ private:
             return;
         }
 
-        if( m_reference_counter->is_monotonic_allocated() )
-        {
-            m_reference_counter->~reference_counter();
-            std::free( m_reference_counter );
-        }
-        else
-        {
-            delete m_reference_counter;
-        }
+        reference_counter< thread_policy >::deallocate( m_reference_counter );
         m_reference_counter = nullptr;
     }
 };
 
+#ifndef NTSP_NO_EXTERN_TEMPLATES
+#define NTSP_EXTERN_WEAK_POINTER( Value ) \
+    extern template class weak_pointer< Value, thread_policy_e::safe >; \
+    extern template class weak_pointer< Value, thread_policy_e::unsafe >; \
+    extern template class weak_pointer< Value, thread_policy_e::biased >;
+NTSP_FOR_EACH_COMMON_VALUE_TYPE( NTSP_EXTERN_WEAK_POINTER )
+#undef NTSP_EXTERN_WEAK_POINTER
+#endif
+
 }
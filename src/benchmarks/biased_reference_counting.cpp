@@ -0,0 +1,82 @@
+#include <benchmark/benchmark.h>
+#include <ntsp/shared_pointer.h>
+
+#include <thread>
+#include <vector>
+
+using namespace ntsp;
+
+namespace {
+
+using safe_pointer = shared_pointer< int, thread_policy_e::safe >;
+using biased_pointer = shared_pointer< int, thread_policy_e::biased >;
+
+// Everything happens on the thread that made the value, the case biased counting is built for
+template< typename Pointer >
+void owner_copy( benchmark::State & state )
+{
+    const auto pointer = Pointer::make( 42 );
+    for( auto _ : state )
+    {
+        Pointer copy( pointer );
+        benchmark::DoNotOptimize( copy.get() );
+    }
+}
+
+template< typename Pointer >
+void owner_fan_out( benchmark::State & state )
+{
+    const auto pointer = Pointer::make( 42 );
+    std::vector< Pointer > copies( static_cast< std::size_t >( state.range( 0 ) ) );
+    for( auto _ : state )
+    {
+        for( auto & copy : copies )
+        {
+            copy = pointer;
+        }
+        for( auto & copy : copies )
+        {
+            copy = Pointer();
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed( state.iterations() * state.range( 0 ) );
+}
+
+// Made on a thread that is gone by now, so every benchmark thread counts through the shared part
+template< typename Pointer >
+const Pointer & foreign_pointer()
+{
+    static const auto pointer = []()
+    {
+        Pointer made;
+        std::thread( [ &made ]()
+        {
+            made = Pointer::make( 42 );
+        } ).join();
+        return made;
+    }();
+    return pointer;
+}
+
+template< typename Pointer >
+void cross_thread_copy( benchmark::State & state )
+{
+    const auto & pointer = foreign_pointer< Pointer >();
+    for( auto _ : state )
+    {
+        Pointer copy( pointer );
+        benchmark::DoNotOptimize( copy.get() );
+    }
+}
+
+}
+
+BENCHMARK_TEMPLATE( owner_copy, safe_pointer );
+BENCHMARK_TEMPLATE( owner_copy, biased_pointer );
+
+BENCHMARK_TEMPLATE( owner_fan_out, safe_pointer )->Arg( 1024 );
+BENCHMARK_TEMPLATE( owner_fan_out, biased_pointer )->Arg( 1024 );
+
+BENCHMARK_TEMPLATE( cross_thread_copy, safe_pointer )->ThreadRange( 1, 8 )->UseRealTime();
+BENCHMARK_TEMPLATE( cross_thread_copy, biased_pointer )->ThreadRange( 1, 8 )->UseRealTime();
@@ -0,0 +1,30 @@
+# Usage: cmake -DCOMPILER=<c++> -DINCLUDE_DIR=<dir> -DSOURCE=<tu.cpp> -DOUTPUT_DIR=<dir> [-DITERATIONS=<n>] -P compile_time.cmake
+# Compiles SOURCE with and without ntsp extern templates and reports the average wall time and object size.
+
+if( NOT ITERATIONS )
+	set( ITERATIONS 5 )
+endif()
+
+function( measure NAME DEFINITIONS OPTIMIZATION )
+	set( OBJECT "${OUTPUT_DIR}/${NAME}.o" )
+	string( TIMESTAMP START "%s%f" )
+	foreach( ITERATION RANGE 1 ${ITERATIONS} )
+		execute_process(
+			COMMAND "${COMPILER}" -std=c++20 ${OPTIMIZATION} ${DEFINITIONS} -I "${INCLUDE_DIR}" -c "${SOURCE}" -o "${OBJECT}"
+			RESULT_VARIABLE RESULT
+		)
+		if( NOT RESULT EQUAL 0 )
+			message( FATAL_ERROR "NTSP: failed to compile ${SOURCE}" )
+		endif()
+	endforeach()
+	string( TIMESTAMP STOP "%s%f" )
+
+	math( EXPR AVERAGE "( ${STOP} - ${START} ) / ${ITERATIONS} / 1000" )
+	file( SIZE "${OBJECT}" SIZE )
+	message( STATUS "NTSP: ${NAME} ${OPTIMIZATION}: ${AVERAGE} ms, ${SIZE} bytes" )
+endfunction()
+
+foreach( OPTIMIZATION -O0 -O2 )
+	measure( "implicit_instantiation" "-DNTSP_NO_EXTERN_TEMPLATES" ${OPTIMIZATION} )
+	measure( "extern_templates" "" ${OPTIMIZATION} )
+endforeach()
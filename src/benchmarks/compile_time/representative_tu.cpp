@@ -0,0 +1,30 @@
+#include <ntsp/shared_pointer.h>
+#include <ntsp/weak_pointer.h>
+
+using namespace ntsp;
+
+int representative_tu()
+{
+    auto result = 0;
+
+    auto i1 = make_shared< int >( 1 );
+    auto i2 = i1;
+    auto w1 = weak_pointer< int >( i2 );
+    result += *w1.lock();
+
+    auto l1 = make_shared< long, thread_policy_e::unsafe >( 2L );
+    auto l2 = std::move( l1 );
+    auto w2 = weak_pointer< long, thread_policy_e::unsafe >( l2 );
+    result += static_cast< int >( *w2.lock() );
+
+    auto d1 = shared_pointer< double >::make( 3.0 );
+    auto d2 = d1;
+    d1 = d2;
+    result += static_cast< int >( *d1 );
+
+    auto u1 = shared_pointer< unsigned long, thread_policy_e::unsafe >( new unsigned long( 4 ) );
+    auto w3 = weak_pointer< unsigned long, thread_policy_e::unsafe >( u1 );
+    result += w3.expired() ? 0 : static_cast< int >( *u1 );
+
+    return result;
+}
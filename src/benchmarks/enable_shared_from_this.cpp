@@ -0,0 +1,89 @@
+#include <benchmark/benchmark.h>
+#include <ntsp/enable_shared_from_this.h>
+
+#include <memory>
+
+using namespace ntsp;
+
+namespace {
+
+template< thread_policy_e Policy >
+struct Classic : public enable_shared_from_this< Classic< Policy >, Policy >
+{
+    int value = 42;
+};
+
+template< thread_policy_e Policy >
+struct Compact : public compact_enable_shared_from_this< Compact< Policy >, Policy >
+{
+    int value = 42;
+};
+
+struct Standard : public std::enable_shared_from_this< Standard >
+{
+    int value = 42;
+};
+
+template< typename Value >
+auto make_value()
+{
+    if constexpr( std::is_same_v< Value, Standard > )
+    {
+        return std::make_shared< Standard >();
+    }
+    else
+    {
+        return shared_pointer< Value, Value::thread_policy >::make();
+    }
+}
+
+template< typename Value >
+void shared_from_this( benchmark::State & state )
+{
+    const auto pointer = make_value< Value >();
+    for( auto _ : state )
+    {
+        auto shared = pointer->shared_from_this();
+        benchmark::DoNotOptimize( shared.get() );
+    }
+    state.counters[ "sizeof" ] = sizeof( Value );
+}
+
+template< typename Value >
+void make( benchmark::State & state )
+{
+    for( auto _ : state )
+    {
+        auto pointer = make_value< Value >();
+        benchmark::DoNotOptimize( pointer.get() );
+    }
+    state.counters[ "sizeof" ] = sizeof( Value );
+}
+
+// A single raw adopted value makes every lookup of the type go through the table
+template< thread_policy_e Policy >
+void shared_from_this_compact_with_adopted( benchmark::State & state )
+{
+    using pointer_type = shared_pointer< Compact< Policy >, Policy >;
+    const auto pointer = pointer_type::make();
+    const auto adopted = pointer_type( new Compact< Policy > );
+    for( auto _ : state )
+    {
+        auto shared = pointer->shared_from_this();
+        benchmark::DoNotOptimize( shared.get() );
+    }
+}
+
+}
+
+BENCHMARK_TEMPLATE( shared_from_this, Classic< thread_policy_e::safe > );
+BENCHMARK_TEMPLATE( shared_from_this, Compact< thread_policy_e::safe > );
+BENCHMARK_TEMPLATE( shared_from_this_compact_with_adopted, thread_policy_e::safe );
+BENCHMARK_TEMPLATE( shared_from_this, Classic< thread_policy_e::unsafe > );
+BENCHMARK_TEMPLATE( shared_from_this, Compact< thread_policy_e::unsafe > );
+BENCHMARK_TEMPLATE( shared_from_this_compact_with_adopted, thread_policy_e::unsafe );
+BENCHMARK_TEMPLATE( shared_from_this, Standard );
+
+BENCHMARK_TEMPLATE( make, Classic< thread_policy_e::safe > );
+BENCHMARK_TEMPLATE( make, Compact< thread_policy_e::safe > );
+BENCHMARK_TEMPLATE( make, Standard );
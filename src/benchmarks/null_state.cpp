@@ -0,0 +1,64 @@
+#include <benchmark/benchmark.h>
+#include <ntsp/shared_pointer.h>
+#include <ntsp/weak_pointer.h>
+
+#include <memory>
+#include <vector>
+
+using namespace ntsp;
+
+namespace {
+
+template< typename Pointer >
+struct Members
+{
+    Pointer first;
+    Pointer second;
+    Pointer third;
+    Pointer fourth;
+};
+
+template< typename Pointer >
+void vector_resize( benchmark::State & state )
+{
+    const auto size = static_cast< std::size_t >( state.range( 0 ) );
+    for( auto _ : state )
+    {
+        std::vector< Pointer > pointers;
+        pointers.resize( size );
+        benchmark::DoNotOptimize( pointers.data() );
+    }
+    state.SetItemsProcessed( state.iterations() * state.range( 0 ) );
+}
+
+template< typename Pointer >
+void default_construct_members( benchmark::State & state )
+{
+    for( auto _ : state )
+    {
+        Members< Pointer > members;
+        benchmark::DoNotOptimize( &members );
+    }
+}
+
+template< typename Weak, typename Pointer >
+void weak_from_empty( benchmark::State & state )
+{
+    const Pointer empty;
+    for( auto _ : state )
+    {
+        Weak weak( empty );
+        benchmark::DoNotOptimize( weak.lock() );
+    }
+}
+
+}
+
+BENCHMARK_TEMPLATE( vector_resize, shared_pointer< int > )->Arg( 1024 )->Arg( 65536 );
+BENCHMARK_TEMPLATE( vector_resize, std::shared_ptr< int > )->Arg( 1024 )->Arg( 65536 );
+
+BENCHMARK_TEMPLATE( default_construct_members, shared_pointer< int > );
+BENCHMARK_TEMPLATE( default_construct_members, std::shared_ptr< int > );
+
+BENCHMARK_TEMPLATE( weak_from_empty, weak_pointer< int >, shared_pointer< int > );
+BENCHMARK_TEMPLATE( weak_from_empty, std::weak_ptr< int >, std::shared_ptr< int > );
@@ -0,0 +1,122 @@
+#include <benchmark/benchmark.h>
+#include <ntsp/shared_queue.h>
+#include <ntsp/shared_stack.h>
+
+#include <deque>
+#include <mutex>
+
+using namespace ntsp;
+
+namespace {
+
+using pointer_type = shared_pointer< int >;
+
+// Baselines, the same container guarded by one mutex
+class locked_queue final
+{
+public:
+    void push( pointer_type value )
+    {
+        std::lock_guard lock( m_mutex );
+        m_values.push_back( std::move( value ) );
+    }
+
+    pointer_type pop()
+    {
+        std::lock_guard lock( m_mutex );
+        if( m_values.empty() )
+        {
+            return pointer_type();
+        }
+        auto value = std::move( m_values.front() );
+        m_values.pop_front();
+        return value;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::deque< pointer_type > m_values;
+};
+
+class locked_stack final
+{
+public:
+    void push( pointer_type value )
+    {
+        std::lock_guard lock( m_mutex );
+        m_values.push_back( std::move( value ) );
+    }
+
+    pointer_type pop()
+    {
+        std::lock_guard lock( m_mutex );
+        if( m_values.empty() )
+        {
+            return pointer_type();
+        }
+        auto value = std::move( m_values.back() );
+        m_values.pop_back();
+        return value;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::deque< pointer_type > m_values;
+};
+
+template< typename Container >
+Container & shared_container()
+{
+    static Container container;
+    return container;
+}
+
+// Every thread pushes its item and pops one back, the item circulates without being copied
+template< typename Container >
+void push_pop_pairs( benchmark::State & state )
+{
+    auto & container = shared_container< Container >();
+    auto item = pointer_type::make( state.thread_index() );
+    for( auto _ : state )
+    {
+        container.push( std::move( item ) );
+        item = container.pop();
+        benchmark::DoNotOptimize( item.get() );
+    }
+    state.SetItemsProcessed( state.iterations() * 2 );
+}
+
+// Half of the threads produce, the other half consume the same number of items
+template< typename Container >
+void producers_consumers( benchmark::State & state )
+{
+    auto & container = shared_container< Container >();
+    const auto producer = state.thread_index() % 2 == 0;
+    for( auto _ : state )
+    {
+        if( producer )
+        {
+            container.push( pointer_type::make( 42 ) );
+        }
+        else
+        {
+            auto item = container.pop();
+            while( item.empty() )
+            {
+                item = container.pop();
+            }
+            benchmark::DoNotOptimize( item.get() );
+        }
+    }
+    state.SetItemsProcessed( state.iterations() );
+}
+
+}
+
+BENCHMARK_TEMPLATE( push_pop_pairs, shared_queue< int > )->ThreadRange( 1, 16 )->UseRealTime();
+BENCHMARK_TEMPLATE( push_pop_pairs, locked_queue )->ThreadRange( 1, 16 )->UseRealTime();
+BENCHMARK_TEMPLATE( push_pop_pairs, shared_stack< int > )->ThreadRange( 1, 16 )->UseRealTime();
+BENCHMARK_TEMPLATE( push_pop_pairs, locked_stack )->ThreadRange( 1, 16 )->UseRealTime();
+
+BENCHMARK_TEMPLATE( producers_consumers, shared_queue< int > )->DenseThreadRange( 2, 16, 2 )->UseRealTime();
+BENCHMARK_TEMPLATE( producers_consumers, locked_queue )->DenseThreadRange( 2, 16, 2 )->UseRealTime();
@@ -1 +1,11 @@
 #include <ntsp/reference_counter.h>
+
+namespace ntsp {
+
+#ifndef NTSP_NO_EXTERN_TEMPLATES
+template class reference_counter< thread_policy_e::safe >;
+template class reference_counter< thread_policy_e::unsafe >;
+template class reference_counter< thread_policy_e::biased >;
+#endif
+
+}
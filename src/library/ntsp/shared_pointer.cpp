@@ -0,0 +1,14 @@
+#include <ntsp/shared_pointer.h>
+
+namespace ntsp {
+
+#ifndef NTSP_NO_EXTERN_TEMPLATES
+#define NTSP_INSTANTIATE_SHARED_POINTER( Value ) \
+    template class shared_pointer< Value, thread_policy_e::safe >; \
+    template class shared_pointer< Value, thread_policy_e::unsafe >; \
+    template class shared_pointer< Value, thread_policy_e::biased >;
+NTSP_FOR_EACH_COMMON_VALUE_TYPE( NTSP_INSTANTIATE_SHARED_POINTER )
+#undef NTSP_INSTANTIATE_SHARED_POINTER
+#endif
+
+}
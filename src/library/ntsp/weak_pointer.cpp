@@ -0,0 +1,14 @@
+#include <ntsp/weak_pointer.h>
+
+namespace ntsp {
+
+#ifndef NTSP_NO_EXTERN_TEMPLATES
+#define NTSP_INSTANTIATE_WEAK_POINTER( Value ) \
+    template class weak_pointer< Value, thread_policy_e::safe >; \
+    template class weak_pointer< Value, thread_policy_e::unsafe >; \
+    template class weak_pointer< Value, thread_policy_e::biased >;
+NTSP_FOR_EACH_COMMON_VALUE_TYPE( NTSP_INSTANTIATE_WEAK_POINTER )
+#undef NTSP_INSTANTIATE_WEAK_POINTER
+#endif
+
+}
@@ -0,0 +1,221 @@
+#include "gtest/gtest.h"
+#include <ntsp/enable_shared_from_this.h>
+#include <ntsp/region.h>
+#include <ntsp/shared_pointer.h>
+#include <ntsp/weak_pointer.h>
+
+#include <thread>
+#include <vector>
+
+using namespace ntsp;
+
+namespace {
+
+struct Counted
+{
+    explicit Counted( std::atomic_int & destroyed ) noexcept : destroyed( destroyed )
+    {
+
+    }
+
+    ~Counted()
+    {
+        ++destroyed;
+    }
+
+    std::atomic_int & destroyed;
+};
+
+struct SharedCounted : Counted, enable_shared_from_this< SharedCounted, thread_policy_e::biased >
+{
+    using Counted::Counted;
+};
+
+using biased_pointer = shared_pointer< Counted, thread_policy_e::biased >;
+using biased_weak_pointer = weak_pointer< Counted, thread_policy_e::biased >;
+
+}
+
+TEST( ntsp, biased_owner_thread )
+{
+    std::atomic_int destroyed{ 0 };
+    auto s1 = biased_pointer::make( destroyed );
+    const auto w1 = biased_weak_pointer( s1 );
+    {
+        auto s2 = s1;
+        ASSERT_EQ( s1.use_count(), 2u );
+        ASSERT_FALSE( w1.lock().empty() );
+    }
+    ASSERT_EQ( s1.use_count(), 1u );
+
+    s1 = biased_pointer();
+    ASSERT_EQ( destroyed, 1 );
+    ASSERT_TRUE( w1.expired() );
+    ASSERT_TRUE( w1.lock().empty() );
+}
+
+TEST( ntsp, biased_owner_releases_last )
+{
+    std::atomic_int destroyed{ 0 };
+    auto s1 = biased_pointer::make( destroyed );
+
+    std::thread( [ &s1 ]()
+    {
+        auto s2 = s1;
+        auto s3 = s1;
+    } ).join();
+    ASSERT_EQ( destroyed, 0 );
+
+    s1 = biased_pointer();
+    ASSERT_EQ( destroyed, 1 );
+}
+
+TEST( ntsp, biased_other_thread_releases_last )
+{
+    std::atomic_int destroyed{ 0 };
+    auto s1 = biased_pointer::make( destroyed );
+    const auto w1 = biased_weak_pointer( s1 );
+
+    // The copy is counted by the owner, so dropping it elsewhere queues the counter back to the owner
+    std::thread( [ s2 = s1 ]() mutable
+    {
+        s2 = biased_pointer();
+    } ).join();
+
+    std::thread( [ &s1 ]()
+    {
+        auto s3 = s1;
+    } ).join();
+    s1 = biased_pointer();
+    ASSERT_EQ( destroyed, 0 );
+    ASSERT_FALSE( w1.expired() );
+
+    process_biased_releases();
+    ASSERT_EQ( destroyed, 1 );
+    ASSERT_TRUE( w1.expired() );
+}
+
+TEST( ntsp, biased_queued_then_merged_by_owner )
+{
+    std::atomic_int destroyed{ 0 };
+    auto p = biased_pointer::make( destroyed );
+    auto q = p;
+    const auto w = biased_weak_pointer( p );
+
+    // Queued once the shared part goes negative, then back to zero before the owner merges it
+    biased_pointer r;
+    std::thread( [ &p, &q, &r ]()
+    {
+        q = biased_pointer();
+        r = p;
+    } ).join();
+
+    r = biased_pointer();
+    p = biased_pointer();
+    ASSERT_EQ( destroyed, 0 );
+
+    process_biased_releases();
+    ASSERT_EQ( destroyed, 1 );
+    ASSERT_TRUE( w.expired() );
+    ASSERT_TRUE( w.lock().empty() );
+}
+
+TEST( ntsp, biased_queued_region_counter_torn_down )
+{
+    std::atomic_int destroyed{ 0 };
+    {
+        region< thread_policy_e::biased > arena;
+        auto p = make_in< Counted >( arena, destroyed );
+        auto q = p;
+
+        // Queued on the owner, which only merges it once the region is gone
+        std::thread( [ &q ]()
+        {
+            q = biased_pointer();
+        } ).join();
+
+        p = biased_pointer();
+        ASSERT_EQ( destroyed, 0 );
+    }
+    ASSERT_EQ( destroyed, 1 );
+
+    process_biased_releases();
+    ASSERT_EQ( destroyed, 1 );
+}
+
+TEST( ntsp, biased_owner_exits_first )
+{
+    std::atomic_int destroyed{ 0 };
+    biased_pointer s1;
+    std::thread( [ &s1, &destroyed ]()
+    {
+        s1 = biased_pointer::make( destroyed );
+    } ).join();
+
+    const auto w1 = biased_weak_pointer( s1 );
+    ASSERT_FALSE( w1.expired() );
+
+    s1 = biased_pointer();
+    ASSERT_EQ( destroyed, 1 );
+    ASSERT_TRUE( w1.expired() );
+}
+
+TEST( ntsp, biased_across_threads )
+{
+    std::atomic_int destroyed{ 0 };
+    auto shared = biased_pointer::make( destroyed );
+    const auto weak = biased_weak_pointer( shared );
+
+    std::vector< std::thread > threads;
+    for( auto thread = 0; thread < 4; ++thread )
+    {
+        threads.emplace_back( [ shared, &weak ]()
+        {
+            for( auto index = 0; index < 10000; ++index )
+            {
+                auto copy = shared;
+                auto locked = weak.lock();
+            }
+        } );
+    }
+    for( auto & thread : threads )
+    {
+        thread.join();
+    }
+
+    ASSERT_EQ( destroyed, 0 );
+    ASSERT_EQ( shared.use_count(), 1u );
+
+    shared = biased_pointer();
+    process_biased_releases();
+    ASSERT_EQ( destroyed, 1 );
+}
+
+TEST( ntsp, biased_shared_from_this_across_threads )
+{
+    std::atomic_int destroyed{ 0 };
+    auto shared = shared_pointer< SharedCounted, thread_policy_e::biased >::make( destroyed );
+    const auto value = shared.get();
+
+    std::vector< std::thread > threads;
+    for( auto thread = 0; thread < 2; ++thread )
+    {
+        threads.emplace_back( [ value ]()
+        {
+            for( auto index = 0; index < 10000; ++index )
+            {
+                auto self = value->shared_from_this();
+            }
+        } );
+    }
+    for( auto & thread : threads )
+    {
+        thread.join();
+    }
+
+    ASSERT_EQ( destroyed, 0 );
+
+    shared = shared_pointer< SharedCounted, thread_policy_e::biased >();
+    process_biased_releases();
+    ASSERT_EQ( destroyed, 1 );
+}
@@ -0,0 +1,115 @@
+#include "gtest/gtest.h"
+#include <ntsp/shared_pointer.h>
+#include <ntsp/weak_pointer.h>
+#include <ntsp/region.h>
+
+#include <thread>
+#include <vector>
+
+using namespace ntsp;
+
+namespace {
+
+struct Counted
+{
+    explicit Counted( std::atomic_int & destroyed ) noexcept : destroyed( destroyed )
+    {
+
+    }
+
+    ~Counted()
+    {
+        ++destroyed;
+    }
+
+    std::atomic_int & destroyed;
+};
+
+}
+
+TEST( ntsp, deferred_release_until_flush )
+{
+    std::atomic_int destroyed{ 0 };
+    {
+        deferred_release_scope scope;
+
+        auto s1 = shared_pointer< Counted >::make( destroyed );
+        auto w1 = weak_pointer< Counted >( s1 );
+        for( auto index = 0; index < 10; ++index )
+        {
+            auto copy = s1;
+        }
+        s1 = shared_pointer< Counted >::make( destroyed );
+
+        ASSERT_EQ( destroyed, 0 );
+        ASSERT_FALSE( w1.lock().empty() );
+
+        scope.flush();
+        ASSERT_EQ( destroyed, 1 );
+        ASSERT_TRUE( w1.expired() );
+        ASSERT_TRUE( w1.lock().empty() );
+    }
+
+    ASSERT_EQ( destroyed, 2 );
+}
+
+TEST( ntsp, deferred_release_flushes_when_full )
+{
+    std::atomic_int destroyed{ 0 };
+    deferred_release_scope scope;
+
+    for( std::size_t index = 0; index < detail::deferred_release_buffer::max_pending; ++index )
+    {
+        auto s1 = shared_pointer< Counted >::make( destroyed );
+    }
+
+    ASSERT_EQ( destroyed, static_cast< int >( detail::deferred_release_buffer::max_pending ) );
+}
+
+TEST( ntsp, deferred_release_across_threads )
+{
+    std::atomic_int destroyed{ 0 };
+    auto shared = shared_pointer< Counted >::make( destroyed );
+    const auto weak = weak_pointer< Counted >( shared );
+
+    std::vector< std::thread > threads;
+    for( auto thread = 0; thread < 4; ++thread )
+    {
+        threads.emplace_back( [ shared ]()
+        {
+            deferred_release_scope scope;
+            for( auto index = 0; index < 10000; ++index )
+            {
+                auto copy = shared;
+                if( index % 1000 == 0 )
+                {
+                    flush_deferred_releases();
+                }
+            }
+        } );
+    }
+    shared = shared_pointer< Counted >::make( destroyed );
+
+    for( auto & thread : threads )
+    {
+        thread.join();
+    }
+
+    ASSERT_EQ( destroyed, 1 );
+    ASSERT_TRUE( weak.expired() );
+}
+
+TEST( ntsp, deferred_release_skips_region_counters )
+{
+    std::atomic_int destroyed{ 0 };
+    deferred_release_scope scope;
+    {
+        region<> region;
+        auto s1 = make_in< Counted >( region, destroyed );
+        auto s2 = s1;
+    }
+    ASSERT_EQ( destroyed, 1 );
+
+    scope.flush();
+    ASSERT_EQ( destroyed, 1 );
+}
@@ -27,3 +27,80 @@ TEST( ntsp, enable_shared_from_this )
     ASSERT_TRUE( s1->value == s2->value );
     ASSERT_TRUE( s1.get() == s2.get() );
 }
+
+namespace {
+
+struct Payload
+{
+    virtual ~Payload() = default;
+    int payload = 7;
+};
+
+struct Compact : public Payload, public compact_enable_shared_from_this< Compact >
+{
+    explicit Compact( int value ) noexcept : value( value )
+    {
+
+    }
+
+    int value;
+};
+
+struct Plain : public Payload
+{
+    int value;
+};
+
+}
+
+TEST( ntsp, compact_enable_shared_from_this_is_empty )
+{
+    static_assert( sizeof( Compact ) == sizeof( Plain ) );
+}
+
+TEST( ntsp, compact_enable_shared_from_this_made )
+{
+    auto s1 = shared_pointer< Compact >::make( 42 );
+    auto s2 = s1->shared_from_this();
+
+    ASSERT_TRUE( s1 == s2 );
+    ASSERT_EQ( s2->value, 42 );
+    ASSERT_EQ( s2->payload, 7 );
+    ASSERT_EQ( s1.use_count(), 2u );
+
+    const auto w1 = s1->weak_from_this();
+    s1 = shared_pointer< Compact >();
+    s2 = shared_pointer< Compact >();
+    ASSERT_TRUE( w1.expired() );
+}
+
+TEST( ntsp, compact_enable_shared_from_this_adopted )
+{
+    auto made = shared_pointer< Compact >::make( 1 );
+    auto s1 = shared_pointer< Compact >( new Compact( 42 ) );
+    auto s2 = s1->shared_from_this();
+
+    ASSERT_TRUE( s1 == s2 );
+    ASSERT_EQ( s1.use_count(), 2u );
+    ASSERT_TRUE( made->shared_from_this() == made );
+
+    s1 = shared_pointer< Compact >();
+    s2 = shared_pointer< Compact >();
+    ASSERT_TRUE( made->shared_from_this() == made );
+}
+
+TEST( ntsp, enable_shared_from_this_multiple_inheritance )
+{
+    struct Classic : public Payload, public enable_shared_from_this< Classic >
+    {
+        int value = 42;
+    };
+
+    auto s1 = shared_pointer< Classic >::make();
+    auto s2 = s1->shared_from_this();
+    ASSERT_TRUE( s1.get() == s2.get() );
+    ASSERT_EQ( s2->value, 42 );
+
+    auto s3 = shared_pointer< Classic >( new Classic );
+    ASSERT_TRUE( s3->shared_from_this() == s3 );
+}
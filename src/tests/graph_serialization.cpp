@@ -0,0 +1,172 @@
+#include "gtest/gtest.h"
+#include <ntsp/graph_serialization.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+using namespace ntsp;
+
+namespace {
+
+struct Node
+{
+    int value = 0;
+    shared_pointer< Node > left{};
+    shared_pointer< Node > right{};
+};
+
+}
+
+template<>
+struct ntsp::graph_traits< Node >
+{
+    static void save( const Node & node, graph_output< Node > & output )
+    {
+        output.write( node.value );
+        output.write_edge( node.left );
+        output.write_edge( node.right );
+    }
+
+    static Node load( graph_input< Node > & input )
+    {
+        Node node;
+        node.value = input.read< int >();
+        node.left = input.read_edge();
+        node.right = input.read_edge();
+        return node;
+    }
+};
+
+namespace {
+
+shared_pointer< Node > make_diamond()
+{
+    auto bottom = make_shared< Node >( Node{ 3 } );
+    auto left = make_shared< Node >( Node{ 1, bottom } );
+    auto right = make_shared< Node >( Node{ 2, bottom } );
+    return make_shared< Node >( Node{ 0, left, right } );
+}
+
+}
+
+TEST( ntsp, graph_serialization_preserves_sharing )
+{
+    std::stringstream stream;
+    save_graph( stream, make_diamond() );
+
+    const auto root = load_graph< Node >( stream );
+
+    ASSERT_EQ( root->value, 0 );
+    ASSERT_EQ( root->left->value, 1 );
+    ASSERT_EQ( root->right->value, 2 );
+    ASSERT_EQ( root->left->left->value, 3 );
+    ASSERT_TRUE( root->left->left == root->right->left );
+    ASSERT_TRUE( root->left->right.empty() );
+}
+
+TEST( ntsp, graph_serialization_arena_outlives_loader )
+{
+    std::stringstream stream;
+    save_graph( stream, make_diamond() );
+
+    auto bottom = [ &stream ]()
+    {
+        return load_graph< Node >( stream )->left->left;
+    }();
+
+    ASSERT_EQ( bottom->value, 3 );
+}
+
+TEST( ntsp, graph_serialization_rejects_garbage )
+{
+    std::stringstream stream( "definitely not a graph, but long enough for a header" );
+    ASSERT_THROW( load_graph< Node >( stream ), std::runtime_error );
+}
+
+TEST( ntsp, graph_serialization_rejects_malformed_record )
+{
+    std::stringstream saved;
+    save_graph( saved, make_diamond() );
+
+    // A payload size that wraps the record size around to zero
+    auto bytes = saved.str();
+    const auto payload_size = ~std::uint64_t( 0 ) - 15;
+    std::memcpy( bytes.data() + sizeof( detail::graph_header ), &payload_size, sizeof( payload_size ) );
+
+    std::stringstream stream( bytes );
+    ASSERT_THROW( load_graph< Node >( stream ), std::runtime_error );
+}
+
+TEST( ntsp, graph_serialization_rejects_oversized_node_count )
+{
+    std::stringstream saved;
+    save_graph( saved, make_diamond() );
+
+    auto bytes = saved.str();
+    const auto node_count = std::uint64_t( 1 ) << 60;
+    std::memcpy( bytes.data() + offsetof( detail::graph_header, node_count ), &node_count, sizeof( node_count ) );
+
+    std::stringstream stream( bytes );
+    ASSERT_THROW( load_graph< Node >( stream ), std::runtime_error );
+}
+
+TEST( ntsp, graph_serialization_rejects_node_count_overflowing_arena )
+{
+    std::stringstream saved;
+    save_graph( saved, make_diamond() );
+
+    // Consistent with an index at the end of the address space, which a stream that can not seek does not bound
+    auto bytes = saved.str();
+    const auto index_offset = ~std::uint64_t( 0 );
+    const auto node_count = ( index_offset - sizeof( detail::graph_header ) ) / sizeof( detail::graph_record );
+    std::memcpy( bytes.data() + offsetof( detail::graph_header, node_count ), &node_count, sizeof( node_count ) );
+    std::memcpy( bytes.data() + offsetof( detail::graph_header, index_offset ), &index_offset, sizeof( index_offset ) );
+
+    struct unseekable_buffer final : std::stringbuf
+    {
+        using std::stringbuf::stringbuf;
+
+        pos_type seekoff( off_type, std::ios_base::seekdir, std::ios_base::openmode ) override
+        {
+            return pos_type( off_type( -1 ) );
+        }
+
+        pos_type seekpos( pos_type, std::ios_base::openmode ) override
+        {
+            return pos_type( off_type( -1 ) );
+        }
+    } buffer( bytes );
+    std::istream stream( &buffer );
+    ASSERT_THROW( load_graph< Node >( stream ), std::runtime_error );
+}
+
+#ifdef NTSP_HAS_MAPPED_GRAPH
+
+TEST( ntsp, graph_serialization_mapped )
+{
+    const auto path = ::testing::TempDir() + "ntsp_graph_serialization_mapped.bin";
+    {
+        std::ofstream file( path, std::ios::binary );
+        save_graph( file, make_diamond() );
+    }
+
+    {
+        mapped_graph< Node > graph( path );
+        ASSERT_EQ( graph.size(), 4u );
+
+        const auto bottom = graph.load( 0 );
+        ASSERT_EQ( bottom->value, 3 );
+
+        const auto root = graph.root();
+        ASSERT_EQ( root->value, 0 );
+        ASSERT_TRUE( root->left->left == bottom );
+        ASSERT_TRUE( root->right->left == bottom );
+    }
+
+    std::remove( path.c_str() );
+}
+
+#endif
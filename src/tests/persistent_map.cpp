@@ -0,0 +1,114 @@
+#include "gtest/gtest.h"
+#include <ntsp/persistent_map.h>
+
+#include <string>
+
+using namespace ntsp;
+
+namespace {
+
+struct CollidingHash
+{
+    std::size_t operator ()( int key ) const noexcept
+    {
+        return static_cast< std::size_t >( key % 3 );
+    }
+};
+
+}
+
+TEST( ntsp, persistent_map_versions )
+{
+    persistent_map< std::string, int > empty;
+    auto m1 = empty.set( "one", 1 );
+    auto m2 = m1.set( "two", 2 );
+    auto m3 = m2.set( "one", 11 ).erase( "two" );
+
+    ASSERT_TRUE( empty.empty() );
+    ASSERT_EQ( *m1.find( "one" ), 1 );
+    ASSERT_FALSE( m1.contains( "two" ) );
+    ASSERT_EQ( *m2.find( "two" ), 2 );
+    ASSERT_EQ( *m3.find( "one" ), 11 );
+    ASSERT_EQ( m3.size(), 1u );
+}
+
+TEST( ntsp, persistent_map_many_keys )
+{
+    constexpr auto count = 20000;
+
+    persistent_map< int, int, std::hash< int >, thread_policy_e::unsafe > map;
+    for( auto key = 0; key < count; ++key )
+    {
+        map = map.set( key, key * 2 );
+    }
+    const auto full = map;
+
+    for( auto key = 0; key < count; key += 2 )
+    {
+        map = map.erase( key );
+    }
+
+    ASSERT_EQ( full.size(), static_cast< std::size_t >( count ) );
+    ASSERT_EQ( map.size(), static_cast< std::size_t >( count / 2 ) );
+    for( auto key = 0; key < count; ++key )
+    {
+        ASSERT_EQ( *full.find( key ), key * 2 );
+        ASSERT_EQ( map.contains( key ), key % 2 == 1 );
+    }
+
+    auto sum = 0ll;
+    map.for_each( [ &sum ]( int, int value ) { sum += value; } );
+    ASSERT_EQ( sum, static_cast< long long >( count / 2 ) * count );
+}
+
+TEST( ntsp, persistent_map_collisions )
+{
+    persistent_map< int, int, CollidingHash > map;
+    for( auto key = 0; key < 30; ++key )
+    {
+        map = map.set( key, key );
+    }
+    for( auto key = 0; key < 30; key += 3 )
+    {
+        map = map.erase( key );
+    }
+
+    ASSERT_EQ( map.size(), 20u );
+    for( auto key = 0; key < 30; ++key )
+    {
+        ASSERT_EQ( map.contains( key ), key % 3 != 0 );
+    }
+}
+
+TEST( ntsp, transient_map_edits_in_place )
+{
+    auto transient = persistent_map< int, int >().transient();
+    for( auto key = 0; key < 1000; ++key )
+    {
+        transient.set( key, key );
+    }
+
+    // Nodes owned by the transient alone are edited in place, copying would move the entry
+    const auto value = transient.find( 500 );
+    transient.set( 500, 1 );
+    transient.set( 500, 2 );
+    ASSERT_EQ( transient.find( 500 ), value );
+    transient.set( 500, 500 );
+
+    const auto snapshot = transient.persistent();
+    for( auto key = 0; key < 1000; ++key )
+    {
+        transient.set( key, -key );
+    }
+    transient.erase( 0 );
+
+    // Shared with the snapshot, so the first edit copied the path and the snapshot kept the original
+    ASSERT_NE( transient.find( 500 ), value );
+    ASSERT_EQ( snapshot.find( 500 ), value );
+
+    ASSERT_EQ( snapshot.size(), 1000u );
+    ASSERT_EQ( transient.size(), 999u );
+    ASSERT_EQ( *snapshot.find( 500 ), 500 );
+    ASSERT_EQ( *transient.find( 500 ), -500 );
+    ASSERT_EQ( transient.find( 0 ), nullptr );
+}
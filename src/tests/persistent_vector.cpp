@@ -0,0 +1,79 @@
+#include "gtest/gtest.h"
+#include <ntsp/persistent_vector.h>
+
+using namespace ntsp;
+
+TEST( ntsp, persistent_vector_versions )
+{
+    persistent_vector< int > empty;
+    auto v1 = empty.push_back( 1 );
+    auto v2 = v1.push_back( 2 );
+    auto v3 = v2.set( 0, 42 );
+
+    ASSERT_TRUE( empty.empty() );
+    ASSERT_EQ( v1.size(), 1u );
+    ASSERT_EQ( v2[ 1 ], 2 );
+    ASSERT_EQ( v2[ 0 ], 1 );
+    ASSERT_EQ( v3[ 0 ], 42 );
+    ASSERT_THROW( static_cast< void >( v3.at( 2 ) ), std::out_of_range );
+}
+
+TEST( ntsp, persistent_vector_grows_and_shrinks )
+{
+    constexpr auto count = 40000;
+
+    persistent_vector< int, thread_policy_e::unsafe > vector;
+    for( auto index = 0; index < count; ++index )
+    {
+        vector = vector.push_back( index );
+    }
+    const auto full = vector;
+
+    for( auto index = count; index > 1; --index )
+    {
+        vector = vector.pop_back();
+        ASSERT_EQ( vector[ index - 2 ], index - 2 );
+    }
+
+    ASSERT_EQ( vector.size(), 1u );
+    ASSERT_EQ( full.size(), static_cast< std::size_t >( count ) );
+    for( auto index = 0; index < count; ++index )
+    {
+        ASSERT_EQ( full[ index ], index );
+    }
+}
+
+TEST( ntsp, transient_vector_edits_in_place )
+{
+    auto transient = persistent_vector< int, thread_policy_e::unsafe >().transient();
+    for( auto index = 0; index < 2000; ++index )
+    {
+        transient.push_back( index );
+    }
+
+    // Nodes owned by the transient alone are edited in place, copying would move the element
+    const auto element = &transient[ 1500 ];
+    transient.set( 1500, 1 );
+    transient.set( 1500, 2 );
+    ASSERT_EQ( &transient[ 1500 ], element );
+    transient.set( 1500, 1500 );
+
+    const auto snapshot = transient.persistent();
+    for( auto index = 0; index < 2000; ++index )
+    {
+        transient.set( index, -index );
+    }
+    transient.pop_back();
+
+    // Shared with the snapshot, so the first edit copied the path and the snapshot kept the original
+    ASSERT_NE( &transient[ 1500 ], element );
+    ASSERT_EQ( &snapshot[ 1500 ], element );
+
+    ASSERT_EQ( snapshot.size(), 2000u );
+    ASSERT_EQ( transient.size(), 1999u );
+    for( auto index = 0; index < 1999; ++index )
+    {
+        ASSERT_EQ( snapshot[ index ], index );
+        ASSERT_EQ( transient[ index ], -index );
+    }
+}
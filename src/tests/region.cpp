@@ -0,0 +1,104 @@
+#include "gtest/gtest.h"
+#include <ntsp/region.h>
+#include <ntsp/weak_pointer.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace ntsp;
+
+namespace {
+
+struct Counted
+{
+    explicit Counted( int & destroyed ) noexcept : destroyed( destroyed )
+    {
+
+    }
+
+    ~Counted()
+    {
+        ++destroyed;
+    }
+
+    int & destroyed;
+    shared_pointer< Counted > next;
+};
+
+}
+
+TEST( ntsp, region_make_in )
+{
+    region<> scope( 128 );
+
+    auto s1 = make_in< int >( scope, 42 );
+    auto s2 = s1;
+    std::vector< shared_pointer< uint64_t > > values;
+    for( uint64_t index = 0; index < 100; ++index )
+    {
+        values.push_back( make_in< uint64_t >( scope, index ) );
+    }
+
+    ASSERT_EQ( *s2, 42 );
+    ASSERT_EQ( *values[ 99 ], 99u );
+}
+
+TEST( ntsp, region_runs_pending_destructors )
+{
+    auto destroyed = 0;
+    {
+        region<> scope;
+
+        auto first = make_in< Counted >( scope, destroyed );
+        auto second = make_in< Counted >( scope, destroyed );
+        first->next = second;
+        second->next = first;
+
+        auto released = make_in< Counted >( scope, destroyed );
+        released = shared_pointer< Counted >( nullptr );
+        ASSERT_EQ( destroyed, 1 );
+    }
+
+    ASSERT_EQ( destroyed, 3 );
+}
+
+TEST( ntsp, region_weak_pointer_outlives_region )
+{
+    weak_pointer< int > weak;
+    {
+        region<> scope;
+        const auto shared = make_in< int >( scope, 42 );
+        weak = weak_pointer< int >( shared );
+        ASSERT_FALSE( weak.expired() );
+    }
+
+    ASSERT_TRUE( weak.expired() );
+}
+
+TEST( ntsp, region_weak_pointers_released_during_teardown )
+{
+    std::vector< weak_pointer< int > > weak;
+    std::atomic_bool start{ false };
+    std::thread releaser;
+    {
+        region<> scope;
+        for( auto index = 0; index < 64; ++index )
+        {
+            weak.emplace_back( make_in< int >( scope, index ) );
+        }
+
+        releaser = std::thread( [ &weak, &start ]()
+        {
+            while( ! start.load() )
+            {
+
+            }
+            weak.clear();
+        } );
+        start = true;
+    }
+    releaser.join();
+
+    ASSERT_TRUE( weak.empty() );
+}
@@ -1,5 +1,8 @@
 #include "gtest/gtest.h"
 #include <ntsp/shared_pointer.h>
+#include <ntsp/weak_pointer.h>
+
+#include <vector>
 
 using namespace ntsp;
 
@@ -11,3 +14,76 @@ TEST( ntsp, shared_ptr_move )
     ASSERT_TRUE( s1.empty() );
     ASSERT_TRUE( *s2 = 42 );
 }
+
+TEST( ntsp, shared_ptr_empty )
+{
+    shared_pointer< uint64_t > s1;
+    auto s2 = s1;
+    auto s3 = shared_pointer< uint64_t >( nullptr );
+    s3 = s2;
+    s2 = std::move( s1 );
+
+    std::vector< shared_pointer< uint64_t > > values;
+    values.resize( 16 );
+    values[ 0 ] = shared_pointer< uint64_t >::make( 42 );
+    values.resize( 1 );
+
+    ASSERT_TRUE( s2.empty() );
+    ASSERT_TRUE( s3.empty() );
+    ASSERT_TRUE( s2 == s3 );
+    ASSERT_EQ( s3.use_count(), 0u );
+    ASSERT_EQ( *values[ 0 ], 42u );
+}
+
+TEST( ntsp, shared_ptr_assign_moved_from )
+{
+    auto s1 = shared_pointer< uint64_t >::make( 42 );
+    auto s2 = std::move( s1 );
+    s1 = shared_pointer< uint64_t >::make( 666 );
+    s1 = s2;
+
+    ASSERT_EQ( *s1, 42u );
+    ASSERT_EQ( s1.use_count(), 2u );
+}
+
+namespace {
+
+struct Large
+{
+    static void * operator new( std::size_t size )
+    {
+        ++allocated;
+        return ::operator new( size );
+    }
+
+    static void operator delete( void * memory ) noexcept
+    {
+        ++released;
+        ::operator delete( memory );
+    }
+
+    inline static int allocated = 0;
+    inline static int released = 0;
+
+    char payload[ NTSP_SPLIT_ALLOCATION_THRESHOLD + 1 ] = {};
+};
+
+}
+
+TEST( ntsp, shared_ptr_split_allocation )
+{
+    Large::allocated = Large::released = 0;
+
+    auto s1 = shared_pointer< Large >::make();
+    auto w1 = weak_pointer< Large >( s1 );
+    ASSERT_EQ( Large::allocated, 1 );
+
+    s1 = shared_pointer< Large >();
+    ASSERT_TRUE( w1.expired() );
+    ASSERT_EQ( Large::released, 1 );
+
+    auto s2 = shared_pointer< Large >::make< allocation_layout_e::single_block >();
+    auto s3 = shared_pointer< uint64_t >::make< allocation_layout_e::split >( 42 );
+    ASSERT_EQ( Large::allocated, 1 );
+    ASSERT_EQ( *s3, 42u );
+}
@@ -0,0 +1,153 @@
+#include "gtest/gtest.h"
+#include <ntsp/shared_queue.h>
+#include <ntsp/shared_stack.h>
+#include <ntsp/weak_pointer.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+using namespace ntsp;
+
+namespace {
+
+constexpr auto producers = 4;
+constexpr auto consumers = 4;
+constexpr auto items = 20000;
+
+template< typename Container >
+std::vector< int > transfer( Container & container )
+{
+    std::atomic_int remaining{ producers * items };
+    std::vector< std::vector< int > > popped( consumers );
+
+    std::vector< std::thread > threads;
+    for( auto producer = 0; producer < producers; ++producer )
+    {
+        threads.emplace_back( [ &container, producer ]()
+        {
+            for( auto index = 0; index < items; ++index )
+            {
+                container.push( shared_pointer< int >::make( producer * items + index ) );
+            }
+        } );
+    }
+    for( auto consumer = 0; consumer < consumers; ++consumer )
+    {
+        threads.emplace_back( [ &container, &remaining, &popped = popped[ consumer ] ]()
+        {
+            while( remaining.load() > 0 )
+            {
+                if( auto value = container.pop(); ! value.empty() )
+                {
+                    ASSERT_EQ( value.use_count(), 1u );
+                    popped.push_back( *value );
+                    --remaining;
+                }
+            }
+        } );
+    }
+    for( auto & thread : threads )
+    {
+        thread.join();
+    }
+
+    std::vector< int > all;
+    for( const auto & values : popped )
+    {
+        all.insert( all.end(), values.begin(), values.end() );
+    }
+    std::sort( all.begin(), all.end() );
+    return all;
+}
+
+}
+
+TEST( ntsp, shared_queue_fifo )
+{
+    shared_queue< int > queue;
+    ASSERT_TRUE( queue.empty() );
+    ASSERT_TRUE( queue.pop().empty() );
+
+    for( auto index = 0; index < 100; ++index )
+    {
+        queue.push( shared_pointer< int >::make( index ) );
+    }
+    ASSERT_FALSE( queue.empty() );
+
+    for( auto index = 0; index < 100; ++index )
+    {
+        ASSERT_EQ( *queue.pop(), index );
+    }
+    ASSERT_TRUE( queue.empty() );
+}
+
+TEST( ntsp, shared_stack_lifo )
+{
+    shared_stack< int > stack;
+    ASSERT_TRUE( stack.empty() );
+    ASSERT_TRUE( stack.pop().empty() );
+
+    for( auto index = 0; index < 100; ++index )
+    {
+        stack.push( shared_pointer< int >::make( index ) );
+    }
+    for( auto index = 99; index >= 0; --index )
+    {
+        ASSERT_EQ( *stack.pop(), index );
+    }
+    ASSERT_TRUE( stack.empty() );
+}
+
+TEST( ntsp, shared_queue_moves_ownership )
+{
+    shared_queue< int > queue;
+    auto pushed = shared_pointer< int >::make( 42 );
+    const auto weak = weak_pointer< int >( pushed );
+    const auto address = pushed.get();
+
+    queue.push( std::move( pushed ) );
+    ASSERT_FALSE( weak.expired() );
+
+    auto popped = queue.pop();
+    ASSERT_EQ( popped.get(), address );
+    ASSERT_EQ( popped.use_count(), 1u );
+
+    popped = shared_pointer< int >();
+    ASSERT_TRUE( weak.expired() );
+}
+
+TEST( ntsp, shared_queue_releases_remaining )
+{
+    auto pushed = shared_pointer< int >::make( 42 );
+    const auto weak = weak_pointer< int >( pushed );
+    {
+        shared_queue< int > queue;
+        queue.push( std::move( pushed ) );
+    }
+    ASSERT_TRUE( weak.expired() );
+}
+
+TEST( ntsp, shared_queue_concurrent )
+{
+    shared_queue< int > queue;
+    const auto all = transfer( queue );
+
+    ASSERT_EQ( all.size(), std::size_t( producers * items ) );
+    for( auto index = 0; index < producers * items; ++index )
+    {
+        ASSERT_EQ( all[ index ], index );
+    }
+}
+
+TEST( ntsp, shared_stack_concurrent )
+{
+    shared_stack< int > stack;
+    const auto all = transfer( stack );
+
+    ASSERT_EQ( all.size(), std::size_t( producers * items ) );
+    for( auto index = 0; index < producers * items; ++index )
+    {
+        ASSERT_EQ( all[ index ], index );
+    }
+}
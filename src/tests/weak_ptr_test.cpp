@@ -31,3 +31,14 @@ TEST( ntsp, copy_assign )
 
     w1 = w2;
 }
+
+TEST( ntsp, weak_ptr_empty )
+{
+    weak_pointer< int > w1;
+    auto w2 = weak_pointer< int >( shared_pointer< int >() );
+    w1 = w2;
+
+    ASSERT_TRUE( w1.expired() );
+    ASSERT_TRUE( w2.expired() );
+    ASSERT_TRUE( w1.lock().empty() );
+}